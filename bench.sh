@@ -0,0 +1,141 @@
+#!/bin/bash
+# File:     bench.sh
+# Purpose:  Benchmark p3 on synthetic graphs from gen_graph and print
+#           strong- and weak-scaling tables for the dense and sparse
+#           engines.
+#
+# Run:      ./bench.sh [-g <shape>] [-p "<procs>"] [-n "<sizes>"]
+#              [-d "<densities>"] [-e "<engines>"] [-s <seed>]
+#              [-w <weak n per process>] [-r <mpiexec command>]
+#              [-a "<p3 args>"] [-c "<build flags>"]
+#
+#           -g:  graph shape for gen_graph:  er, rmat, grid or disc (er)
+#           -p:  process counts ("1 2 4")
+#           -n:  numbers of vertices for strong scaling ("1024 2048")
+#           -d:  densities ("0.01 0.1")
+#           -e:  engines ("dense sparse")
+#           -s:  seed for gen_graph (1)
+#           -w:  vertices per process for weak scaling (512)
+#           -r:  command used to start p3 ("mpiexec")
+#           -a:  extra arguments for p3, e.g. "-H" ("")
+#           -c:  extra flags for mpicc, e.g. "-fopenmp -DWEIGHT_U16" ("")
+#
+# Output:   One row per run with the p3 -T timers:  solve is the
+#           average over the processes of the min + comm + relax time,
+#           comm is the slowest process' collective time, and speedup
+#           and efficiency are relative to the first process count.
+#
+# Note:     Graphs are written to $BENCH_DIR (/tmp/p3_bench) and
+#           reused, so a rerun with the same seed uses the same graphs.
+#           p3 and gen_graph are rebuilt there whenever their sources
+#           are newer, with one p3 for each set of build flags.  The
+#           graphs are written with the weight type of any -DWEIGHT_*
+#           in the build flags.  The script stops if p3 fails.
+
+shape=er
+procs="1 2 4"
+sizes="1024 2048"
+densities="0.01 0.1"
+engines="dense sparse"
+seed=1
+weak_n=512
+run=mpiexec
+args=""
+cflags=""
+dir=${BENCH_DIR:-/tmp/p3_bench}
+here=$(cd "$(dirname "$0")" && pwd)
+
+while getopts "g:p:n:d:e:s:w:r:a:c:" opt; do
+   case $opt in
+      g) shape=$OPTARG ;;
+      p) procs=$OPTARG ;;
+      n) sizes=$OPTARG ;;
+      d) densities=$OPTARG ;;
+      e) engines=$OPTARG ;;
+      s) seed=$OPTARG ;;
+      w) weak_n=$OPTARG ;;
+      r) run=$OPTARG ;;
+      a) args=$OPTARG ;;
+      c) cflags=$OPTARG ;;
+      *) sed -n '7,21p' "$0" >&2; exit 1 ;;
+   esac
+done
+
+mkdir -p "$dir"
+p3=$dir/p3-$(printf %s "$cflags" | cksum | cut -d' ' -f1)
+[ "$here/p3.c" -nt "$p3" ] && { mpicc -O2 $cflags -o "$p3" "$here/p3.c" \
+   || exit 1; }
+[ "$here/gen_graph.c" -nt "$dir/gen_graph" ] && { gcc -O2 -o \
+   "$dir/gen_graph" "$here/gen_graph.c" -lm || exit 1; }
+
+# The graphs have to store the weight type p3 was built for
+case " $cflags " in
+   *" -DWEIGHT_U8 "*) wt=u8 ;;
+   *" -DWEIGHT_U16 "*) wt=u16 ;;
+   *" -DWEIGHT_U32 "*) wt=u32 ;;
+   *" -DWEIGHT_U64 "*) wt=u64 ;;
+   *" -DWEIGHT_FLOAT "*) wt=f32 ;;
+   *" -DWEIGHT_DOUBLE "*) wt=f64 ;;
+   *) wt=i32 ;;
+esac
+
+# Graph <n> <density> <engine>:  print the name of the graph file,
+# generating it if it doesn't exist
+Graph() {
+   local f="$dir/$shape-$1-$2-$seed-$wt-$3.bin" flag=""
+   [ "$3" = sparse ] && flag=-s
+   [ -f "$f" ] || "$dir/gen_graph" $shape $1 $2 $seed "$f" $flag -t $wt \
+      > /dev/null || return 1
+   echo "$f"
+}
+
+# Run <p> <graph>:  print "solve comm" in seconds, or print p3's 
+# errors and fail if it fails
+Run() {
+   local err
+   err=$($run -n $1 "$p3" -f "$2" $args -T csv 2>&1 > /dev/null) || {
+      echo "$err" >&2
+      return 1
+   }
+   echo "$err" | awk -F, '
+      $1 == "min" || $1 == "relax" { solve += $4 }
+      $1 == "comm" { solve += $4; comm = $3 }
+      END { printf "%.6f %.6f\n", solve, comm }'
+}
+
+# Table <title> [weak]:  run every configuration and print a table.
+# Weak scaling keeps n/p fixed, so its ideal efficiency is a constant
+# solve time.
+Table() {
+   local weak=$2 n n0 d e p f t base list
+   printf "\n%s scaling (%s, seed %s)\n" "$1" "$shape" "$seed"
+   printf "%-7s %4s %8s %8s %10s %10s %8s %6s\n" engine p n density \
+      "solve(s)" "comm(s)" speedup eff
+   list=$sizes
+   [ "$weak" ] && list=$weak_n
+   for e in $engines; do
+      for d in $densities; do
+         for n0 in $list; do
+            base=""
+            for p in $procs; do
+               n=$n0
+               [ "$weak" ] && n=$((n0*p))
+               f=$(Graph $n $d $e) || exit 1
+               t=$(Run $p "$f") || exit 1
+               t=($t)
+               [ "$base" ] || base="${t[0]} $p"
+               awk -v e=$e -v p=$p -v n=$n -v d=$d -v s=${t[0]} \
+                   -v c=${t[1]} -v b="$base" -v weak="$weak" 'BEGIN {
+                  split(b, x, " ")
+                  sp = (s > 0) ? x[1]/s : 0
+                  ef = weak ? sp : sp*x[2]/p
+                  printf "%-7s %4d %8d %8s %10.6f %10.6f %8.2f %6.2f\n",
+                     e, p, n, d, s, c, sp, ef }'
+            done
+         done
+      done
+   done
+}
+
+Table Strong
+Table Weak weak
@@ -0,0 +1,539 @@
+/* File:     gen_graph.c
+ * Purpose:  Generate synthetic directed graphs for benchmarking p3.
+ *           The graphs are written as p3 binary graph files (note 4
+ *           in p3.c), so they can be loaded with p3 -f.  The same
+ *           seed always gives the same edges, for both layouts and
+ *           on every platform.
+ *
+ * Compile:  gcc -g -Wall -O2 -o gen_graph gen_graph.c -lm
+ * Run:      ./gen_graph <shape> <n> <density> <seed> <graph> [-s]
+ *              [-z] [-w <max_wt>] [-c <comps>] [-t <type>]
+ *
+ *           shape:  er:    Erdos-Renyi.  Each edge u->v, u != v, is
+ *                          present with probability density.
+ *                   rmat:  R-MAT (Kronecker) power-law graph with
+ *                          density*n*n edge samples and the
+ *                          probabilities (0.57, 0.19, 0.19, 0.05)
+ *                   grid:  road-like 2D grid with about sqrt(n)
+ *                          columns.  Each vertex has edges to and
+ *                          from its 4 neighbors; a fraction density
+ *                          of them is dropped.
+ *                   disc:  comps disconnected Erdos-Renyi components.
+ *                          Vertex v is in component v % comps, so
+ *                          each component is spread over every
+ *                          process.
+ *           -s:  write LAYOUT_CSC for the sparse engine instead of
+ *                LAYOUT_DENSE
+ *           -z:  write LAYOUT_CSC_PACKED, the compressed edge list 
+ *                (note 26 in p3.c), for the sparse engine
+ *           -w:  weights are uniform in 1..max_wt (100)
+ *           -c:  number of components for disc (4)
+ *           -t:  weight type:  i32, u8, u16, u32, u64, f32 or f64
+ *                (i32).
+ *                A p3 built with the matching -DWEIGHT_ flag loads
+ *                the graph (note 15 in p3.c).
+ *
+ * Notes:
+ * 1. The random numbers come from splitmix64, so they don't depend
+ *    on the C library.
+ * 2. Parallel edges keep the smallest weight, and self loops are
+ *    dropped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include <float.h>
+
+#define NO_EDGE 1000000      /* INFINITY in p3.c */
+
+/* Must match the header in p3.c */
+#define GRAPH_MAGIC "DJKG"
+#define GRAPH_VERSION 1
+#define WT_INT32 0
+#define WT_UINT16 1
+#define WT_UINT32 2
+#define WT_UINT64 3
+#define WT_FLOAT32 4
+#define WT_FLOAT64 5
+#define WT_UINT8 6
+#define LAYOUT_DENSE 0
+#define LAYOUT_CSC 1
+#define LAYOUT_CSC_PACKED 2
+typedef struct {
+   char    magic[4];
+   int32_t version;
+   int32_t weight_type;
+   int32_t layout;
+   int64_t n;
+   int64_t m;
+} graph_hdr_t;
+
+/* A growing list of edges */
+typedef struct {
+   int64_t  m;
+   int64_t  max_m;
+   int32_t* e;        /* u, v, w triples */
+} edges_t;
+
+/* The names of the weight types for -t, indexed by WT_ code */
+const char* wt_names[] = {"i32", "u16", "u32", "u64", "f32", "f64", "u8"};
+#define N_WT_TYPES 7
+
+uint64_t Next(uint64_t* state);
+int   Rand_wt(uint64_t* state, int max_wt);
+double Rand_unif(uint64_t* state);
+void  Add_edge(edges_t* g, int u, int v, int w);
+void  Gen_er(edges_t* g, int n, double density, int comps, int max_wt,
+   uint64_t* state);
+void  Gen_rmat(edges_t* g, int n, double density, int max_wt,
+   uint64_t* state);
+void  Gen_grid(edges_t* g, int n, double density, int max_wt,
+   uint64_t* state);
+int   Write_graph(char fname[], edges_t* g, int n, int sparse, int pack,
+   int wt_type);
+void  Write_wts(int32_t wts[], int64_t count, int wt_type, FILE* fp);
+int   Put_varint(unsigned char buf[], uint64_t x);
+void  Write_packed(int64_t cols_ptr[], int32_t srcs[], int32_t wts[], 
+   int n, int wt_type, FILE* fp);
+void  Usage(char prog_name[]);
+
+/*-------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int n, sparse = 0, pack = 0, max_wt = 100, comps = 4, wt_type = WT_INT32, i;
+   double density;
+   uint64_t state;
+   edges_t g = {0, 0, NULL};
+
+   if (argc < 6) Usage(argv[0]);
+   n = strtol(argv[2], NULL, 10);
+   density = strtod(argv[3], NULL);
+   state = strtoull(argv[4], NULL, 10);
+   for (i = 6; i < argc; i++) {
+      if (strcmp(argv[i], "-s") == 0)
+         sparse = 1;
+      else if (strcmp(argv[i], "-z") == 0)
+         sparse = pack = 1;
+      else if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+         max_wt = strtol(argv[++i], NULL, 10);
+      else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+         comps = strtol(argv[++i], NULL, 10);
+      else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+         i++;
+         for (wt_type = 0; wt_type < N_WT_TYPES; wt_type++)
+            if (strcmp(argv[i], wt_names[wt_type]) == 0) break;
+         if (wt_type == N_WT_TYPES) Usage(argv[0]);
+      } else
+         Usage(argv[0]);
+   }
+   if (n <= 0 || density < 0 || max_wt <= 0 || max_wt >= NO_EDGE
+         || (wt_type == WT_UINT16 && max_wt >= UINT16_MAX) 
+         || (wt_type == WT_UINT8 && max_wt >= UINT8_MAX) || comps <= 0)
+      Usage(argv[0]);
+
+   if (strcmp(argv[1], "er") == 0)
+      Gen_er(&g, n, density, 1, max_wt, &state);
+   else if (strcmp(argv[1], "disc") == 0)
+      Gen_er(&g, n, density, comps, max_wt, &state);
+   else if (strcmp(argv[1], "rmat") == 0)
+      Gen_rmat(&g, n, density, max_wt, &state);
+   else if (strcmp(argv[1], "grid") == 0)
+      Gen_grid(&g, n, density, max_wt, &state);
+   else
+      Usage(argv[0]);
+
+   if (Write_graph(argv[5], &g, n, sparse, pack, wt_type) != 0) {
+      fprintf(stderr, "Can't write %s\n", argv[5]);
+      return 1;
+   }
+   printf("%s:  n = %d, m = %" PRId64 "\n", argv[5], n, g.m);
+
+   free(g.e);
+   return 0;
+}  /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Next
+ * Purpose:   Return the next splitmix64 random number
+ * In/out:    state:  the generator's state
+ */
+uint64_t Next(uint64_t* state) {
+   uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+   z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}  /* Next */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Rand_unif
+ * Purpose:   Return a random double in [0, 1)
+ */
+double Rand_unif(uint64_t* state) {
+   return (Next(state) >> 11)*(1.0/9007199254740992.0);
+}  /* Rand_unif */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Rand_wt
+ * Purpose:   Return a random weight in 1..max_wt
+ */
+int Rand_wt(uint64_t* state, int max_wt) {
+   return 1 + Next(state) % max_wt;
+}  /* Rand_wt */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Add_edge
+ * Purpose:   Append the edge u->v with weight w to g
+ */
+void Add_edge(edges_t* g, int u, int v, int w) {
+   if (g->m == g->max_m) {
+      g->max_m = (g->max_m > 0) ? 2*g->max_m : 1024;
+      g->e = realloc(g->e, 3*g->max_m*sizeof(int32_t));
+   }
+   g->e[3*g->m] = u;
+   g->e[3*g->m + 1] = v;
+   g->e[3*g->m + 2] = w;
+   g->m++;
+}  /* Add_edge */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Gen_er
+ * Purpose:   Generate comps Erdos-Renyi components.  With comps = 1
+ *            it's a single Erdos-Renyi graph.
+ * Note:      The gap to the next edge is geometric, so the time is
+ *            proportional to the number of edges, not to n*n.
+ */
+void Gen_er(edges_t* g, int n, double density, int comps, int max_wt,
+      uint64_t* state) {
+   int64_t slot, size = (int64_t) n*n;
+   double r;
+   int u, v;
+
+   if (density <= 0) return;
+   slot = -1;
+   for (;;) {
+      if (density >= 1) {
+         slot++;
+      } else {
+         r = Rand_unif(state);
+         slot += 1 + (int64_t) (log(1.0 - r)/log(1.0 - density));
+      }
+      if (slot >= size) break;
+      u = slot/n;
+      v = slot % n;
+      if (u != v && u % comps == v % comps)
+         Add_edge(g, u, v, Rand_wt(state, max_wt));
+   }
+}  /* Gen_er */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Gen_rmat
+ * Purpose:   Generate an R-MAT graph.  Each edge is placed by
+ *            choosing one quadrant of the adjacency matrix per bit
+ *            of the vertex numbers.  Samples outside 0..n-1 are
+ *            redrawn.
+ */
+void Gen_rmat(edges_t* g, int n, double density, int max_wt,
+      uint64_t* state) {
+   int64_t i, samples = density*n*n;
+   int scale = 0, b, u, v;
+   double r;
+
+   while ((1LL << scale) < n) scale++;
+   for (i = 0; i < samples; i++) {
+      do {
+         u = v = 0;
+         for (b = 0; b < scale; b++) {
+            r = Rand_unif(state);
+            if (r >= 0.57 && r < 0.76) {
+               v |= 1 << b;
+            } else if (r >= 0.76 && r < 0.95) {
+               u |= 1 << b;
+            } else if (r >= 0.95) {
+               u |= 1 << b;
+               v |= 1 << b;
+            }
+         }
+      } while (u >= n || v >= n);
+      if (u != v) Add_edge(g, u, v, Rand_wt(state, max_wt));
+   }
+}  /* Gen_rmat */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Gen_grid
+ * Purpose:   Generate a 2D grid.  Vertex v is at row v/cols, column
+ *            v % cols, and a fraction density of the edges between
+ *            neighbors is dropped.
+ */
+void Gen_grid(edges_t* g, int n, double density, int max_wt,
+      uint64_t* state) {
+   int cols = 1, v, w, d;
+   int step[2];
+
+   while ((cols + 1)*(cols + 1) <= n) cols++;
+   step[0] = 1;
+   step[1] = cols;
+   for (v = 0; v < n; v++)
+      for (d = 0; d < 2; d++) {
+         w = v + step[d];
+         if (w >= n || (d == 0 && w % cols == 0)) continue;
+         if (Rand_unif(state) >= density)
+            Add_edge(g, v, w, Rand_wt(state, max_wt));
+         if (Rand_unif(state) >= density)
+            Add_edge(g, w, v, Rand_wt(state, max_wt));
+      }
+}  /* Gen_grid */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_edges
+ * Purpose:   qsort comparison:  order edges by destination, then
+ *            source, then weight
+ */
+static int Compare_edges(const void* a, const void* b) {
+   const int32_t* x = a;
+   const int32_t* y = b;
+
+   if (x[1] != y[1]) return (x[1] > y[1]) - (x[1] < y[1]);
+   if (x[0] != y[0]) return (x[0] > y[0]) - (x[0] < y[0]);
+   return (x[2] > y[2]) - (x[2] < y[2]);
+}  /* Compare_edges */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Compare_rows
+ * Purpose:   qsort comparison:  order edges by source, then 
+ *            destination
+ */
+static int Compare_rows(const void* a, const void* b) {
+   const int32_t* x = a;
+   const int32_t* y = b;
+
+   if (x[0] != y[0]) return (x[0] > y[0]) - (x[0] < y[0]);
+   return (x[1] > y[1]) - (x[1] < y[1]);
+}  /* Compare_rows */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Write_graph
+ * Purpose:   Write g to a binary graph file
+ * In args:   fname:  the file to write
+ *            n:  the number of vertices
+ *            sparse:  1 for LAYOUT_CSC, 0 for LAYOUT_DENSE
+ *            pack:  with sparse, write LAYOUT_CSC_PACKED instead
+ *            wt_type:  the WT_ code of the weights in the file
+ * In/out:    g:  the edges.  They're sorted and parallel edges
+ *               are removed.
+ * Ret val:   0 on success
+ */
+int Write_graph(char fname[], edges_t* g, int n, int sparse, int pack,
+      int wt_type) {
+   FILE* fp;
+   graph_hdr_t hdr;
+   int64_t e, m = 0, *cols_ptr;
+   int32_t *row, *srcs, *wts;
+   int u, v;
+
+   /* Sort by destination and keep the lightest parallel edge */
+   qsort(g->e, g->m, 3*sizeof(int32_t), Compare_edges);
+   for (e = 0; e < g->m; e++)
+      if (m == 0 || g->e[3*e] != g->e[3*(m-1)]
+            || g->e[3*e + 1] != g->e[3*(m-1) + 1]) {
+         memmove(&g->e[3*m], &g->e[3*e], 3*sizeof(int32_t));
+         m++;
+      }
+   g->m = m;
+
+   fp = fopen(fname, "wb");
+   if (fp == NULL) return 1;
+   memcpy(hdr.magic, GRAPH_MAGIC, 4);
+   hdr.version = GRAPH_VERSION;
+   hdr.weight_type = wt_type;
+   hdr.n = n;
+   hdr.m = sparse ? m : 0;
+   hdr.layout = pack ? LAYOUT_CSC_PACKED 
+      : (sparse ? LAYOUT_CSC : LAYOUT_DENSE);
+   fwrite(&hdr, sizeof(hdr), 1, fp);
+
+   if (sparse) {
+      cols_ptr = calloc(n + 1, sizeof(int64_t));
+      srcs = malloc(m*sizeof(int32_t));
+      wts = malloc(m*sizeof(int32_t));
+      for (e = 0; e < m; e++) {
+         cols_ptr[g->e[3*e + 1] + 1]++;
+         srcs[e] = g->e[3*e];
+         wts[e] = g->e[3*e + 2];
+      }
+      for (v = 0; v < n; v++)
+         cols_ptr[v+1] += cols_ptr[v];
+      fwrite(cols_ptr, sizeof(int64_t), n + 1, fp);
+      if (pack) {
+         Write_packed(cols_ptr, srcs, wts, n, wt_type, fp);
+      } else {
+         fwrite(srcs, sizeof(int32_t), m, fp);
+         Write_wts(wts, m, wt_type, fp);
+      }
+      free(cols_ptr);
+      free(srcs);
+      free(wts);
+   } else {
+      /* The matrix is row-major, so write one row at a time */
+      qsort(g->e, m, 3*sizeof(int32_t), Compare_rows);
+      row = malloc((size_t) n*sizeof(int32_t));
+      e = 0;
+      for (u = 0; u < n; u++) {
+         for (v = 0; v < n; v++)
+            row[v] = (u == v) ? 0 : NO_EDGE;
+         for ( ; e < m && g->e[3*e] == u; e++)
+            row[g->e[3*e + 1]] = g->e[3*e + 2];
+         Write_wts(row, n, wt_type, fp);
+      }
+      free(row);
+   }
+
+   return fclose(fp);
+}  /* Write_graph */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Write_wts
+ * Purpose:   Convert weights to the type wt_type and write them
+ * In args:   wts:  the weights, with NO_EDGE for a missing edge
+ *            count:  the number of weights
+ *            wt_type:  the WT_ code to write
+ *            fp:  the file
+ * Note:      A missing edge is written as the largest value of the 
+ *            type, which p3 reads as no edge.
+ */
+void Write_wts(int32_t wts[], int64_t count, int wt_type, FILE* fp) {
+   size_t sizes[N_WT_TYPES] = {sizeof(int32_t), sizeof(uint16_t), 
+      sizeof(uint32_t), sizeof(uint64_t), sizeof(float), sizeof(double),
+      sizeof(uint8_t)};
+   char* buf = malloc(count*sizes[wt_type]);
+   int64_t i;
+   int edge;
+
+   for (i = 0; i < count; i++) {
+      edge = (wts[i] < NO_EDGE);
+      switch (wt_type) {
+         case WT_UINT8:
+            ((uint8_t*) buf)[i] = edge ? wts[i] : UINT8_MAX;
+            break;
+         case WT_UINT16:
+            ((uint16_t*) buf)[i] = edge ? wts[i] : UINT16_MAX;
+            break;
+         case WT_UINT32:
+            ((uint32_t*) buf)[i] = edge ? wts[i] : UINT32_MAX;
+            break;
+         case WT_UINT64:
+            ((uint64_t*) buf)[i] = edge ? wts[i] : UINT64_MAX;
+            break;
+         case WT_FLOAT32:
+            ((float*) buf)[i] = edge ? wts[i] : FLT_MAX;
+            break;
+         case WT_FLOAT64:
+            ((double*) buf)[i] = edge ? wts[i] : DBL_MAX;
+            break;
+         default:
+            ((int32_t*) buf)[i] = wts[i];
+      }
+   }
+   fwrite(buf, sizes[wt_type], count, fp);
+   free(buf);
+}  /* Write_wts */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Put_varint
+ * Purpose:   Store x in buf as a varint:  7 bits per byte, low bits
+ *            first, with the high bit set when more bytes follow
+ * Ret val:   The number of bytes stored, at most 10
+ */
+int Put_varint(unsigned char buf[], uint64_t x) {
+   int len = 0;
+
+   while (x >= 0x80) {
+      buf[len++] = (x & 0x7f) | 0x80;
+      x >>= 7;
+   }
+   buf[len++] = x;
+   return len;
+}  /* Put_varint */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Write_packed
+ * Purpose:   Write the byte offsets and the packed columns of a
+ *            LAYOUT_CSC_PACKED file (note 26 in p3.c)
+ * In args:   cols_ptr:  the n+1 offsets of the columns
+ *            srcs:  the sources, increasing in each column
+ *            wts:  the weights
+ *            n:  the number of vertices
+ *            wt_type:  the WT_ code to write
+ *            fp:  the file
+ * Note:      Each source is stored as its difference from the last
+ *            one in its column, and integer weights as varints.
+ *            Float weights are stored as they are.
+ */
+void Write_packed(int64_t cols_ptr[], int32_t srcs[], int32_t wts[], 
+      int n, int wt_type, FILE* fp) {
+   unsigned char* buf = malloc(cols_ptr[n]*(5 + sizeof(double)) + 1);
+   int64_t* bytes_ptr = malloc((n + 1)*sizeof(int64_t));
+   int64_t e, size = 0;
+   float f;
+   double d;
+   int v;
+
+   for (v = 0; v < n; v++) {
+      bytes_ptr[v] = size;
+      for (e = cols_ptr[v]; e < cols_ptr[v+1]; e++) {
+         size += Put_varint(buf + size, 
+               srcs[e] - (e > cols_ptr[v] ? srcs[e-1] : 0));
+         if (wt_type == WT_FLOAT32) {
+            f = wts[e];
+            memcpy(buf + size, &f, sizeof(float));
+            size += sizeof(float);
+         } else if (wt_type == WT_FLOAT64) {
+            d = wts[e];
+            memcpy(buf + size, &d, sizeof(double));
+            size += sizeof(double);
+         } else {
+            size += Put_varint(buf + size, wts[e]);
+         }
+      }
+   }
+   bytes_ptr[n] = size;
+
+   fwrite(bytes_ptr, sizeof(int64_t), n + 1, fp);
+   fwrite(buf, 1, size, fp);
+   free(bytes_ptr);
+   free(buf);
+}  /* Write_packed */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a usage message and quit
+ */
+void Usage(char prog_name[]) {
+   fprintf(stderr, "usage: %s <er|rmat|grid|disc> <n> <density> <seed> "
+         "<graph>\n", prog_name);
+   fprintf(stderr, "          [-s] [-z] [-w <max_wt>] [-c <comps>] "
+         "[-t <type>]\n");
+   fprintf(stderr, "   -s:  write LAYOUT_CSC for the sparse engine\n");
+   fprintf(stderr, "   -z:  write LAYOUT_CSC_PACKED for the sparse "
+         "engine\n");
+   fprintf(stderr, "   -w:  weights are in 1..max_wt (100)\n");
+   fprintf(stderr, "   -c:  number of components for disc (4)\n");
+   fprintf(stderr, "   -t:  weight type i32, u8, u16, u32, u64, f32 or "
+         "f64 (i32)\n");
+   exit(1);
+}  /* Usage */
@@ -13,19 +13,111 @@
  *           interruption by another process.
  *
  * Compile:  mpicc -g -Wall -o p3 p3.c
- * Run:      mpiexec -n <p> ./mpi_io (on lab machines)
- *           csmpiexec -n <p> ./mpi_io (on the penguin cluster)
+ *           mpicc -g -Wall -fopenmp -o p3 p3.c  (hybrid MPI + OpenMP)
+ *           Add -mavx2, -mavx512f or -march=native for the SIMD
+ *           kernels (note 8)
+ *           Add -DWEIGHT_U8, -DWEIGHT_U16, -DWEIGHT_U32, -DWEIGHT_U64,
+ *           -DWEIGHT_FLOAT or -DWEIGHT_DOUBLE to change the type of
+ *           the weights and distances from int (notes 15 and 16)
+ *           Add -fopenmp with -foffload=nvptx-none (gcc) or
+ *           -fopenmp-targets=nvptx64 or amdgcn-amd-amdhsa (clang) to
+ *           run -G on a GPU (note 25)
+ * Run:      mpiexec -n <p> ./p3 [-s] [-f <graph> [-i]] [-D <delta>]
+ *              [-S <src>] [-t <targets> [-B]] [-b <sources> [-k <K>]] 
+ *              [-T json|csv] [-P] [-O] [-o <results>] [-q <queries>]
+ *              [-2] [-W] [-H] [-F] [-G] [-z] [-R <radius>] [-E <eps>]
+ *              [-C <checkpoint> [-I <steps>] [-r]] [-x <tree>]
+ *              (on lab machines)
+ *           csmpiexec -n <p> ./p3 [-s] [-f <graph> [-i]] [-D <delta>]
+ *              [-S <src>] [-t <targets> [-B]] [-b <sources> [-k <K>]] 
+ *              [-T json|csv] [-P] [-O] [-o <results>] [-q <queries>]
+ *              [-2] [-W] [-H] [-F] [-G] [-z] [-R <radius>] [-E <eps>]
+ *              [-C <checkpoint> [-I <steps>] [-r]] [-x <tree>]
+ *              (on the penguin cluster)
+ *           ./p3 [-s [-z]] -c <graph> < <text input>  (convert to 
+ *              binary)
+ *
+ *           -s:  use the sparse (CSR) engine instead of the dense
+ *                block-column matrix
+ *           -f:  load the graph from a binary graph file instead of
+ *                reading text from stdin.  The layout stored in the
+ *                file selects the dense or sparse engine.
+ *           -i:  with -f, read the file with collective MPI-IO
+ *                instead of mapping it.  Use this when the file is
+ *                on a parallel filesystem.
+ *           -D:  solve with delta-stepping using buckets of width
+ *                delta instead of Dijkstra's algorithm
+ *           -S:  find the shortest paths from src instead of from 0
+ *           -t:  point-to-point mode:  stop as soon as the vertices
+ *                in the comma-separated list targets are settled and
+ *                print only their distances and paths
+ *           -B:  with a single target t, search from both src and t
+ *                (dense mode only)
+ *           -T:  write the per-phase timings and counters to stderr
+ *                as JSON or CSV (note 12)
+ *           -P:  in sparse mode, size the blocks by their number of
+ *                edges instead of vertices (note 13)
+ *           -O:  in dense mode, reduce a packed 64-bit key with 
+ *                MPI_Iallreduce and overlap it with the local 
+ *                minimum search (note 14)
+ *           -b:  batch mode:  find the shortest paths from each
+ *                vertex listed in the text file sources instead of
+ *                just from 0.  The graph is only read once.
+ *           -k:  in batch mode, the number of sources solved
+ *                together (default BATCH_K)
+ *           -o:  write the distances and predecessors to the binary
+ *                file results with MPI-IO instead of printing them
+ *                (note 17)
+ *           -q:  service mode:  load the graph once and then solve
+ *                each query read from the file or named pipe queries
+ *                (note 18)
+ *           -2:  in dense mode, split the matrix into 2D blocks on a
+ *                grid of processes instead of into block columns 
+ *                (note 20)
+ *           -W:  in dense mode, store the block columns of the 
+ *                processes on a node in one shared memory window 
+ *                (note 21)
+ *           -H:  find the global minimum with a reduction inside each
+ *                node followed by one across the nodes (note 22)
+ *           -F:  in dense mode, mark settled vertices in loc_dist and
+ *                relax and find the next minimum in one pass (note 24)
+ *           -G:  in dense mode, keep the block column, distances and
+ *                predecessors on the GPU and solve there (note 25)
+ *           -z:  pack the edges sent by process 0 when reading
+ *                text, and with -s -c write a compressed edge list
+ *                (note 26)
+ *           -R:  stop once every vertex within distance radius of
+ *                src is settled, and report the rest as unreachable
+ *                (note 27)
+ *           -E:  settle every vertex within a factor 1 + eps of the
+ *                smallest lower bound together, so each distance is
+ *                at most 1 + eps times the shortest (note 27)
+ *           -C:  in dense mode, save Dijkstra's state to the file
+ *                checkpoint every -I steps (default CKPT_STEPS) 
+ *                without waiting for the write (note 28)
+ *           -r:  with -C and -f, resume from the last checkpoint in
+ *                the file instead of starting over
+ *           -x:  write the shortest-path tree, indexed for path and
+ *                ancestor queries, to the binary file tree instead 
+ *                of printing the paths (note 29)
+ *           -c:  read a text graph from stdin and write it to a
+ *                binary graph file, then quit
  *
  * Input:    n:  the number of rows and the number of columns 
  *               in the matrix
  *           mat:  the matrix:  note that INFINITY should be
- *               input as 1000000
+ *               input as 1000000, or as NO_EDGE for the other
+ *               weight types (note 15)
+ *           In sparse mode the matrix is replaced by an edge list:
+ *           m:  the number of edges
+ *           m triples u v w:  an edge u->v with weight w
  * Output:   The submatrix assigned to each process and the
  *           complete matrix printed from process 0.  Both
  *           print "i" instead of 1000000 for infinity.
  *
  * Notes:
- * 1.  The number of processes, p, should evenly divide n.
+ * 1.  Process q owns the vertices first[q], ..., first[q+1]-1 of a
+ *     part_t, so p needn't divide n.
  * 2.  Example:  Suppose the matrix is
  *
  *        0 1 2 3
@@ -40,73 +132,945 @@
  *                 4 0             5 6
  *                 7 8             0 9
  *                 8 7             6 0
+ *
+ * 3.  In sparse mode a process stores only the edges into the vertices
+ *     it owns, grouped by source (csr_t).
+ * 4.  A binary graph file is a graph_hdr_t followed by the matrix or by
+ *     the edges grouped by destination.  Each process maps or reads
+ *     only its own block.
+ * 5.  -D solves with delta-stepping, which needs one exchange per phase
+ *     instead of one reduction per vertex.
+ * 6.  Batch mode solves K sources in lockstep with one reduction of K
+ *     MINLOC pairs per step.
+ * 7.  With OpenMP each process runs the minimum search and the dense
+ *     relaxation on a team of threads.  Only the master thread calls
+ *     MPI.
+ * 8.  The dense Dijkstra keeps known as a bitmap, and its kernels use
+ *     AVX2 or AVX-512 when they're available.
+ * 9.  The sparse solvers keep the local frontier in a 4-ary heap
+ *     (heap_t).
+ * 10. The solvers stop once the global minimum is INFINITY, or with -t
+ *     once every target is settled.  Only the targets' distances are
+ *     then exact.
+ * 11. -B searches forward from src and backward from t at the same
+ *     time.
+ * 12. -T writes the time spent in each phase and the collective counts
+ *     to stderr.
+ * 13. -P sizes the sparse blocks by their edges plus vertices.
+ * 14. -O reduces a packed 64-bit key with MPI_Iallreduce and finds the
+ *     next local minimum while it's in flight.
+ * 15. weight_t and dist_t are chosen at build time with -DWEIGHT_*.  A
+ *     graph file can only be loaded by a build with its weight type.
+ * 16. With 8- or 16-bit weights the distances are int and DIST_ADD
+ *     saturates at INFINITY.
+ * 17. -o writes the results with collective MPI-IO instead of printing
+ *     them from process 0.
+ * 18. -q answers queries, one per line, on the graph that's already
+ *     loaded.
+ * 19. An "update" query changes edge weights and repairs the last tree
+ *     instead of solving again.
+ * 20. -2 stores the matrix in 2D blocks on a pr x pc grid of processes.
+ * 21. -W keeps the block columns of a node in one shared-memory window.
+ * 22. -H reduces the MINLOC pairs inside each node before reducing
+ *     across the nodes.
+ * 23. The arrays every solve needs are allocated once, in one arena.
+ * 24. -F marks settled vertices with the sign bit of loc_dist, and
+ *     relaxes and finds the next minimum in one pass.
+ * 25. -G offloads the dense solver with OpenMP target directives.
+ * 26. -z and LAYOUT_CSC_PACKED store edges as delta-coded varints.
+ * 27. -R stops at a search radius, and -E settles a whole band of
+ *     vertices within a factor 1 + eps of the lower bound each round.
+ * 28. -C checkpoints Dijkstra with nonblocking MPI-IO, and -r restarts
+ *     from the newest checkpoint.
+ * 29. -x and the path queries use an index of the tree by DFS
+ *     intervals.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <limits.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-#define MAX_STRING 10000
+/* Edge weights and path lengths.  See notes 15 and 16.  Both are */
+/* int by default.  Narrow weights keep an int dist_t, 32- and      */
+/* 64-bit unsigned weights use a long, and float and double weights */
+/* a double.  A weight w is an edge if w < NO_EDGE.                 */
+#if defined(WEIGHT_U8) || defined(WEIGHT_U16)
+#define NARROW_WEIGHTS
+#define INT_DIST
+typedef int dist_t;
+typedef unsigned udist_t;
+#define INFINITY INT_MAX
+#define SETTLED_BIT INT_MIN
+#define DIST_MPI MPI_INT
+#define PAIR_MPI MPI_2INT
+#define DIST_FMT "d"
+#define DIST_CODE WT_INT32
+#elif defined(WEIGHT_U32) || defined(WEIGHT_U64)
+typedef long dist_t;
+typedef unsigned long udist_t;
+#define INFINITY (LONG_MAX/2)
+#define SETTLED_BIT LONG_MIN
+#define DIST_MPI MPI_LONG
+#define PAIR_MPI MPI_LONG_INT
+#define DIST_FMT "ld"
+#define DIST_CODE WT_INT64
+#elif defined(WEIGHT_FLOAT) || defined(WEIGHT_DOUBLE)
+typedef double dist_t;
+#define INFINITY DBL_MAX
+#define DIST_MPI MPI_DOUBLE
+#define PAIR_MPI MPI_DOUBLE_INT
+#define DIST_FMT "g"
+#define DIST_CODE WT_FLOAT64
+#else
+#define WEIGHT_INT
+#define INT_DIST
+typedef int dist_t;
+typedef unsigned udist_t;
 #define INFINITY 1000000
+#define SETTLED_BIT INT_MIN
+#define DIST_MPI MPI_INT
+#define PAIR_MPI MPI_2INT
+#define DIST_FMT "d"
+#define DIST_CODE WT_INT32
+#endif
+
+#if defined(WEIGHT_U8)
+typedef uint8_t weight_t;
+#define NO_EDGE UINT8_MAX
+#define WEIGHT_MPI MPI_UINT8_T
+#define WEIGHT_SCN SCNu8
+#define WEIGHT_FMT PRIu8
+#define WEIGHT_CODE WT_UINT8
+#elif defined(WEIGHT_U16)
+typedef uint16_t weight_t;
+#define NO_EDGE UINT16_MAX
+#define WEIGHT_MPI MPI_UINT16_T
+#define WEIGHT_SCN SCNu16
+#define WEIGHT_FMT PRIu16
+#define WEIGHT_CODE WT_UINT16
+#elif defined(WEIGHT_U32)
+typedef uint32_t weight_t;
+#define NO_EDGE UINT32_MAX
+#define WEIGHT_MPI MPI_UINT32_T
+#define WEIGHT_SCN SCNu32
+#define WEIGHT_FMT PRIu32
+#define WEIGHT_CODE WT_UINT32
+#elif defined(WEIGHT_U64)
+typedef uint64_t weight_t;
+#define NO_EDGE ((uint64_t) INFINITY)
+#define WEIGHT_MPI MPI_UINT64_T
+#define WEIGHT_SCN SCNu64
+#define WEIGHT_FMT PRIu64
+#define WEIGHT_CODE WT_UINT64
+#elif defined(WEIGHT_FLOAT)
+typedef float weight_t;
+#define NO_EDGE FLT_MAX
+#define WEIGHT_MPI MPI_FLOAT
+#define WEIGHT_SCN "f"
+#define WEIGHT_FMT "g"
+#define WEIGHT_CODE WT_FLOAT32
+#elif defined(WEIGHT_DOUBLE)
+typedef double weight_t;
+#define NO_EDGE DBL_MAX
+#define WEIGHT_MPI MPI_DOUBLE
+#define WEIGHT_SCN "lf"
+#define WEIGHT_FMT "g"
+#define WEIGHT_CODE WT_FLOAT64
+#else
+typedef int weight_t;
+#define NO_EDGE INFINITY
+#define WEIGHT_MPI MPI_INT
+#define WEIGHT_SCN "d"
+#define WEIGHT_FMT "d"
+#define WEIGHT_CODE WT_INT32
+#endif
+
+/* A settled entry of loc_dist in Dijkstra_fused.  See note 24. */
+#ifdef SETTLED_BIT
+#define SETTLE(d) ((d) | SETTLED_BIT)
+#define UNSETTLE(d) ((d) & ~SETTLED_BIT)
+#endif
+
+/* The length of the one-edge path with weight w */
+#define EDGE_DIST(w) (((w) < NO_EDGE) ? (dist_t) (w) : INFINITY)
+
+/* The length d + w of a path d extended by w, a weight or another */
+/* path.  With narrow weights it saturates at INFINITY = INT_MAX.  */
+#ifdef NARROW_WEIGHTS
+#define DIST_ADD(d, w) ((d) >= INFINITY - (dist_t) (w) ? INFINITY \
+      : (d) + (dist_t) (w))
+#else
+#define DIST_ADD(d, w) ((d) + (w))
+#endif
+
+/* The SIMD kernels need int distances */
+#if defined(INT_DIST) && defined(__AVX512F__)
+#define USE_AVX512
+#elif defined(INT_DIST) && defined(__AVX2__)
+#define USE_AVX2
+#endif
+#if defined(USE_AVX512) || defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+/* Load 16 or 8 weights into int32 lanes, widening narrow weights */
+#if defined(WEIGHT_U8)
+#define LOAD_WTS_16(p) _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*) (p)))
+#define LOAD_WTS_8(p) _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) (p)))
+#elif defined(WEIGHT_U16)
+#define LOAD_WTS_16(p) \
+   _mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i*) (p)))
+#define LOAD_WTS_8(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*) (p)))
+#else
+#define LOAD_WTS_16(p) _mm512_loadu_si512(p)
+#define LOAD_WTS_8(p) _mm256_loadu_si256((__m256i*) (p))
+#endif
+
+#define MAX_STRING 10000
+#define NO_VERTEX INT_MAX
+#define BATCH_K 16
+#define OUT_BUF_SIZE (1 << 20)
+#ifndef OMP_MIN_N
+#define OMP_MIN_N 4096
+#endif
+
+/* Whether global vertex u is one of the loc_n vertices starting */
+/* at first.  See note 1.                                        */
+#define OWNS(first, loc_n, u) ((u) >= (first) && (u) < (first) + (loc_n))
+
+/* The known bitmap used by the dense Dijkstra */
+#define KNOWN_WORDS(n) (((n) + 31)/32)
+#define IS_KNOWN(known, v) (((known)[(v) >> 5] >> ((v) & 31)) & 1)
+#define SET_KNOWN(known, v) ((known)[(v) >> 5] |= 1u << ((v) & 31))
+#define CLEAR_KNOWN(known, v) ((known)[(v) >> 5] &= ~(1u << ((v) & 31)))
+
+/* Packed (distance, vertex) keys for Dijkstra_pipelined.  See note 14. */
+#define KEY(dist, v) (((uint64_t) (dist) << 32) | (uint32_t) (v))
+#define KEY_NONE UINT64_MAX
+
+/* The part of the graph owned by one process in sparse mode.  Only   */
+/* sources with at least one edge into the block are stored, so row r */
+/* holds the edges out of global vertex rows[r].                      */
+typedef struct {
+   int  loc_rows;   /* number of nonempty rows                       */
+   int  loc_m;      /* number of stored edges                        */
+   int* rows;       /* global source of each row, sorted ascending   */
+   int* row_ptr;    /* edges of row r are row_ptr[r] .. row_ptr[r+1]-1 */
+   int* cols;       /* local destination of each edge                */
+   weight_t* wts;   /* weight of each edge                           */
+} csr_t;
+
+/* An edge u->v while the edges are read and distributed */
+typedef struct {
+   int      u;
+   int      v;
+   weight_t w;
+} edge_t;
+
+/* A (distance, vertex) pair with the layout of PAIR_MPI, so it can */
+/* be reduced with MPI_MINLOC                                       */
+typedef struct {
+   dist_t dist;
+   int    v;
+} pair_t;
+
+/* The vertices owned by each process.  See note 1. */
+typedef struct {
+   int  p;
+   int* first;      /* process q owns first[q] .. first[q+1]-1       */
+   int* counts;     /* counts[q] = first[q+1] - first[q]             */
+} part_t;
+
+/* Local frontier of the sparse Dijkstra:  a 4-ary min-heap of      */
+/* vertices ordered by (loc_dist[v], v).  pos[v] is v's index in    */
+/* verts, or -1 if v isn't in the heap.  See note 9.                */
+#define HEAP_D 4
+typedef struct {
+   int  size;
+   int* verts;
+   int* pos;
+   dist_t* keys;        /* loc_dist, owned by the caller */
+} heap_t;
+
+/* A pr x pc grid of processes for the 2D decomposition.  See note 20. */
+typedef struct {
+   int      pr, pc;          /* rows and columns of the grid          */
+   int      my_row, my_col;  /* the calling process' place in it      */
+   part_t   rows;            /* the row blocks of the matrix          */
+   part_t   cols;            /* the column blocks of the matrix       */
+   MPI_Comm row_comm;        /* the processes in my grid row          */
+   MPI_Comm col_comm;        /* the processes in my grid column       */
+} grid_t;
+
+/* Header of a binary graph file.  See note 4.  The payload follows */
+/* in native byte order.  For LAYOUT_DENSE it's the n x n matrix    */
+/* stored by rows.  For LAYOUT_CSC it's n+1 int64 offsets cols_ptr, */
+/* m int32 sources and m weights, so the edges into v are entries   */
+/* cols_ptr[v] .. cols_ptr[v+1]-1.  LAYOUT_CSC_PACKED is described  */
+/* with pack_t.                                                     */
+#define GRAPH_MAGIC "DJKG"
+#define GRAPH_VERSION 1
+#define WT_INT32 0
+#define WT_UINT16 1
+#define WT_UINT32 2
+#define WT_UINT64 3
+#define WT_FLOAT32 4
+#define WT_FLOAT64 5
+#define WT_UINT8 6
+#define WT_INT64 7
+#define LAYOUT_DENSE 0
+#define LAYOUT_CSC 1
+#define LAYOUT_CSC_PACKED 2
+typedef struct {
+   char    magic[4];     /* GRAPH_MAGIC                      */
+   int32_t version;      /* GRAPH_VERSION                    */
+   int32_t weight_type;  /* WEIGHT_CODE of the weights       */
+   int32_t layout;       /* LAYOUT_DENSE, LAYOUT_CSC or      */
+                         /*    LAYOUT_CSC_PACKED             */
+   int64_t n;            /* number of vertices               */
+   int64_t m;            /* number of edges in CSC layouts   */
+} graph_hdr_t;
+
+/* A growing buffer of packed edges.  See note 26.  Ids are stored */
+/* as differences from the last id in the same list, and ids and   */
+/* integer weights as varints:  7 bits per byte, with the high bit */
+/* set when more bytes follow.  Float weights are copied as they   */
+/* are.  A LAYOUT_CSC_PACKED payload is cols_ptr, n+1 int64 byte   */
+/* offsets bytes_ptr, and then column v at bytes_ptr[v]:  the      */
+/* sources of the edges into v in increasing order, each followed  */
+/* by its weight.                                                  */
+#define VARINT_MAX 10    /* bytes in the longest uint64 varint */
+typedef struct {
+   size_t         size;
+   size_t         max_size;
+   unsigned char* bytes;
+} pack_t;
+
+/* Header of a results file written with -o.  See note 17.  It's   */
+/* followed by the n_srcs sources as int32 and then one record per */
+/* source:  n dist_t distances and n int32 predecessors, all in    */
+/* native byte order.                                              */
+#define RESULT_MAGIC "DJKR"
+#define RESULT_VERSION 1
+typedef struct {
+   char    magic[4];     /* RESULT_MAGIC                      */
+   int32_t version;      /* RESULT_VERSION                    */
+   int32_t dist_type;    /* DIST_CODE of the distances        */
+   int32_t n_srcs;       /* number of sources and of records  */
+   int64_t n;            /* number of vertices                */
+} result_hdr_t;
+
+/* Header of a tree index written with -x.  See note 29.  It's  */
+/* followed by n dist_t distances and then n int32 pred, depth, */
+/* tin, tout and order, as in tree_t, all in native byte order. */
+#define TREE_MAGIC "DJKT"
+#define TREE_VERSION 1
+typedef struct {
+   char    magic[4];     /* TREE_MAGIC                        */
+   int32_t version;      /* TREE_VERSION                      */
+   int32_t dist_type;    /* DIST_CODE of the distances        */
+   int32_t src;          /* root of the tree                  */
+   int64_t n;            /* number of vertices                */
+} tree_hdr_t;
+
+/* A shortest-path tree indexed by DFS intervals.  See note 29. */
+typedef struct {
+   int     n, src;
+   dist_t* dist;    /* length of src->v, or INFINITY              */
+   int*    pred;    /* parent of v, or -1 for src and the         */
+                    /*    vertices that can't be reached          */
+   int*    depth;   /* number of edges on src->v, or -1           */
+   int*    tin;     /* preorder number of v, or -1                */
+   int*    tout;    /* largest preorder number in v's subtree, or */
+                    /*    -1                                      */
+   int*    order;   /* order[tin[v]] = v                          */
+} tree_t;
+
+/* Command line options */
+typedef struct {
+   int   sparse;         /* use the CSR engine                   */
+   char* in_file;        /* binary graph to load, or NULL        */
+   char* conv_file;      /* binary graph to write, or NULL       */
+   int   mpi_io;         /* read in_file with MPI-IO, not mmap   */
+   dist_t delta;         /* bucket width for delta-stepping, or  */
+                         /*    0 for Dijkstra                    */
+   char* src_file;       /* list of sources for batch mode, or   */
+                         /*    NULL                              */
+   int   batch_k;        /* number of sources solved together    */
+   int   src;            /* source vertex                        */
+   int*  targets;        /* sorted targets for -t, or NULL       */
+   int   n_targets;      /* number of targets                    */
+   int   bidir;          /* search from both ends of src->t      */
+   char* stats_fmt;      /* "json" or "csv" for -T, or NULL      */
+   int   balance;        /* size sparse blocks by edge count     */
+   int   pipelined;      /* use Dijkstra_pipelined               */
+   char* out_file;       /* results file to write, or NULL       */
+   char* query_file;     /* queries for service mode, or NULL    */
+   int   grid2d;         /* use the 2D decomposition             */
+   int   shared;         /* keep loc_mat in a node's shared window */
+   int   hier;           /* two-level MINLOC reductions          */
+   int   fused;          /* use Dijkstra_fused                   */
+   int   device;         /* use Dijkstra_device                  */
+   int   pack;           /* pack edges sent or written (note 26) */
+   char* tree_file;      /* tree index to write, or NULL         */
+   char* ckpt_file;      /* checkpoint file for -C, or NULL      */
+   long  ckpt_steps;     /* steps between checkpoints            */
+   int   restart;        /* resume from ckpt_file                */
+   dist_t radius;        /* search radius for -R, or INFINITY    */
+   double eps;           /* tolerance for -E, or 0 for exact     */
+} opts_t;
+
+/* What Parse_query found on a line.  See note 18. */
+enum { QUERY_RUN, QUERY_SKIP, QUERY_BAD, QUERY_QUIT, QUERY_UPDATE, 
+   QUERY_PATH };
+
+/* Timers and counters for -T.  See note 12. */
+enum { T_READ_N, T_PARSE, T_SCATTER, T_LOAD, T_MIN, T_COMM, T_RELAX, 
+   T_OUTPUT, T_CKPT, N_TIMERS };
+typedef struct {
+   double    t[N_TIMERS];  /* seconds spent in each phase           */
+   long long colls;        /* collectives called                    */
+   long long bytes;        /* bytes in this process' buffers        */
+   long long settled;      /* vertices settled by this process      */
+} stats_t;
+static stats_t stats;
+#define TIC(t0) ((t0) = MPI_Wtime())
+#define TOC(t0, phase) (stats.t[phase] += MPI_Wtime() - (t0))
+#define COUNT_COLL(nbytes) (stats.colls++, stats.bytes += (nbytes))
+
+/* Communicators for the two-level MINLOC reduction.  See note 22. */
+typedef struct {
+   MPI_Comm comm;         /* the communicator it's used for, or      */
+                          /*    MPI_COMM_NULL for flat reductions   */
+   MPI_Comm node_comm;    /* the processes on my node                */
+   MPI_Comm leader_comm;  /* the first process on each node, or      */
+                          /*    MPI_COMM_NULL on the others         */
+} hier_t;
+static hier_t hier = {MPI_COMM_NULL, MPI_COMM_NULL, MPI_COMM_NULL};
+
+/* Header of a checkpoint file written with -C.  See note 28.  It's */
+/* followed by two slots, each n dist_t distances, n int32          */
+/* predecessors and n bytes that are 1 for the known vertices, all  */
+/* indexed by global vertex.                                        */
+#define CKPT_MAGIC "DJKC"
+#define CKPT_VERSION 2
+#define CKPT_STEPS 4096
+typedef struct {
+   char    magic[4];      /* CKPT_MAGIC                          */
+   int32_t version;       /* CKPT_VERSION                        */
+   int32_t dist_type;     /* DIST_CODE of the distances          */
+   int32_t src;           /* source vertex                       */
+   int64_t n;             /* number of vertices                  */
+   uint64_t graph_hash;   /* Hash_graph of the weights           */
+   uint64_t target_hash;  /* Hash_targets of the -t list         */
+   int64_t step[2];       /* step saved in each slot, or 0 if    */
+                          /*    the slot holds no checkpoint     */
+   int64_t remaining[2];  /* targets left to settle in each slot */
+} ckpt_hdr_t;
+
+/* The checkpoint file and the write in flight.  See note 28. */
+typedef struct {
+   MPI_File       fh;         /* the file, or MPI_FILE_NULL         */
+   long           steps;      /* steps between checkpoints          */
+   int            restart;    /* restore the last checkpoint first  */
+   int            n, loc_n, my_first, my_rank;
+   ckpt_hdr_t     hdr;        /* the slots that have been finished  */
+   int            slot;       /* slot being written, or -1          */
+   int64_t        step;       /* step and remaining being written   */
+   int64_t        remaining;
+   MPI_Request    reqs[3];
+   dist_t*        dist;       /* copies of the state being written  */
+   int*           pred;
+   unsigned char* known;
+} ckpt_t;
+static ckpt_t ckpt = {MPI_FILE_NULL};
+
+/* A bump allocator over one mapping.  See note 23. */
+#define CACHE_LINE 64
+#define HUGE_PAGE ((size_t) 1 << 21)
+#define ALIGN_UP(x, a) (((x) + (a) - 1) & ~((size_t) (a) - 1))
+typedef struct {
+   void*  map;        /* the mapping                             */
+   size_t map_size;
+   char*  base;       /* map rounded up to a huge page           */
+   size_t used;       /* bytes handed out from base              */
+} arena_t;
+
+/* The buffers reused by every solve on the loaded graph.  See note 23. */
+typedef struct {
+   arena_t   arena;     /* holds all of the arrays below           */
+   int       loc_n;
+   dist_t*   loc_dist;  /* the process' distances                  */
+   int*      loc_pred;  /*    and predecessors                     */
+   uint32_t* known;     /* the dense solvers' known bitmap         */
+   int*      stamp;     /* Dijkstra_sparse:  local vertex v is     */
+   int       gen;       /*    known if stamp[v] == gen             */
+   heap_t    heap;      /* the sparse solvers' frontier            */
+   dist_t*   dist;      /* on process 0, the gather buffers of     */
+   int*      pred;      /*    Print_dists and Print_paths, and     */
+   int64_t*  len;       /*    Print_paths' path lengths and stack. */
+   int*      stack;     /*    NULL on the other processes.         */
+} work_t;
+static work_t work;
 
 int Read_n(int my_rank, MPI_Comm comm);
-MPI_Datatype Build_blk_col_type(int n, int loc_n);
-void Read_matrix(int loc_mat[], int n, int loc_n, 
-      MPI_Datatype blk_col_mpi_t, int my_rank, MPI_Comm comm);
-void Print_local_matrix(int loc_mat[], int n, int loc_n, int my_rank);
-void Print_matrix(int loc_mat[], int n, int loc_n, 
-      MPI_Datatype blk_col_mpi_t, int my_rank, MPI_Comm comm);
-int Find_min_dist(int dist[], int known[], int loc_n, int my_rank, 
+MPI_Datatype Build_blk_col_type(int n);
+MPI_Datatype Build_loc_col_type(int n, int loc_n);
+MPI_Datatype Build_edge_type(void);
+void Build_part(int n, int p, part_t* part);
+void Free_part(part_t* part);
+int  Owner(part_t* part, int v);
+void Balance_part(part_t* part, const int64_t cols_ptr[]);
+void Read_matrix(weight_t loc_mat[], weight_t loc_tr[], int n, part_t* part,
+      MPI_Datatype blk_col_mpi_t, MPI_Datatype loc_col_mpi_t, int pack,
+      int my_rank, MPI_Comm comm);
+void Scatter_packed(weight_t mat[], weight_t loc_mat[], int n, 
+   part_t* part, int tr, int my_rank, MPI_Comm comm);
+void Pack_block(pack_t* pk, weight_t mat[], int n, int first, int count,
+   int tr);
+void Unpack_block(const unsigned char bytes[], int nbytes, 
+   weight_t loc_mat[], size_t size);
+void Print_local_matrix(weight_t loc_mat[], int n, int loc_n, int my_rank);
+void Print_matrix(weight_t loc_mat[], int n, part_t* part, 
+      MPI_Datatype blk_col_mpi_t, MPI_Datatype loc_col_mpi_t, int my_rank,
+      MPI_Comm comm);
+int Find_min_dist(dist_t dist[], int known[], int loc_n);
+void Dijkstra(weight_t mat[], dist_t loc_dist[], int loc_pred[], int loc_n, 
+   int my_first, int n, int src, dist_t radius, int targets[], 
+   int n_targets, MPI_Comm comm);
+void Print_dists(dist_t loc_dist[], int n, part_t* part, int src, 
+   int targets[], int n_targets, int my_rank, MPI_Comm comm);
+void Print_paths(int loc_pred[], int n, part_t* part, int src, 
+   int targets[], int n_targets, int my_rank, MPI_Comm comm);
+void Get_args(int argc, char* argv[], opts_t* opts, int my_rank);
+void Usage(char prog_name[]);
+void Read_edges(csr_t* loc_g, part_t* part, int balance, int pack, 
+   int my_rank, MPI_Comm comm);
+void Sort_edges(edge_t edges[], edge_t tmp[], int m, int n);
+void Build_csr(csr_t* loc_g, edge_t edges[], int loc_m);
+int  Pack_rows(pack_t* pk, edge_t edges[], int loc_m);
+void Unpack_rows(csr_t* loc_g, const unsigned char bytes[], int loc_m, 
+   int loc_rows);
+void Pack_col(pack_t* pk, int32_t srcs[], weight_t wts[], int64_t deg);
+void Unpack_cols(const unsigned char bytes[], const int64_t cols_ptr[],
+   int loc_n, edge_t edges[]);
+void Free_csr(csr_t* loc_g);
+int  Find_row(csr_t* loc_g, int u);
+void Relax_sparse(csr_t* loc_g, int u, dist_t u_dist, dist_t loc_dist[],
+   int loc_pred[], int known[], int gen, heap_t* heap);
+void Dijkstra_sparse(csr_t* loc_g, dist_t loc_dist[], int loc_pred[], 
+   int loc_n,
+   int my_first, int n, int src, dist_t radius, int targets[], 
+   int n_targets, MPI_Comm comm);
+void Check_for_error(int local_ok, char message[], MPI_Comm comm);
+void* Map_graph(char fname[], graph_hdr_t* hdr, size_t* size_p, 
+   MPI_Comm comm);
+void Load_dense(void* map, weight_t loc_mat[], int n, int loc_n, 
+   int my_first);
+void Load_csr(void* map, graph_hdr_t* hdr, csr_t* loc_g, int loc_n, 
+   int my_first);
+void Convert_text(char fname[], int sparse, int pack);
+int  Check_hdr(graph_hdr_t* hdr, size_t size);
+size_t Packed_size(graph_hdr_t* hdr, int64_t end);
+void Open_graph(char fname[], graph_hdr_t* hdr, MPI_File* fh_p,
+   MPI_Comm comm);
+void Read_dense_all(MPI_File fh, weight_t loc_mat[], int n, int loc_n,
+   int my_first);
+void Read_csr_all(MPI_File fh, graph_hdr_t* hdr, csr_t* loc_g, int loc_n,
+   int my_first);
+int64_t* Read_cols_ptr_all(MPI_File fh, int n);
+void Delta_stepping(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+   int loc_pred[], int loc_n, int my_first, int p, dist_t delta, int src,
+   dist_t radius, int targets[], int n_targets, MPI_Comm comm);
+int  Gather_frontier(pair_t loc_frontier[], int loc_count, 
+   pair_t** frontier_p, int counts[], int displs[], int p, MPI_Comm comm);
+void Relax_frontier(weight_t loc_mat[], csr_t* loc_g, pair_t frontier[], 
+   int count, int light, dist_t delta, dist_t loc_dist[], int loc_pred[], 
+   int dirty[], int settled[], int loc_n);
+void Dijkstra_approx(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+   int loc_pred[], int loc_n, int my_first, int p, double eps, int src, 
+   dist_t radius, int targets[], int n_targets, MPI_Comm comm);
+void Relax_band(weight_t loc_mat[], csr_t* loc_g, pair_t band[], 
+   int count, dist_t lb_dist, dist_t loc_dist[], int loc_pred[], 
+   dist_t loc_lb[], int settled[], int loc_n);
+void Clip_radius(dist_t loc_dist[], int loc_pred[], int loc_n, 
+   dist_t radius, int src);
+int* Read_sources(char fname[], int n, int* count_p, int my_rank, 
+   MPI_Comm comm);
+void Dijkstra_batch(weight_t loc_mat[], csr_t* loc_g, int srcs[], int k, 
+   dist_t loc_dist[], int loc_pred[], int loc_n, int my_first, int n, 
    MPI_Comm comm);
-void Dijkstra(int mat[], int loc_dist[], int loc_pred[], int loc_n, int my_rank,
-   int n, MPI_Comm comm);
-void Print_dists(int loc_dist[], int n, int loc_n, int my_rank, 
+void Relax_row(weight_t loc_mat[], csr_t* loc_g, int u, dist_t u_dist, 
+   dist_t loc_dist[], int loc_pred[], int known[], heap_t* heap, int loc_n);
+int  Find_min_dist_bits(dist_t loc_dist[], uint32_t known[], int loc_n);
+void Relax_dense(weight_t row[], int u, dist_t u_dist, dist_t loc_dist[], 
+   int loc_pred[], uint32_t known[], int loc_n);
+void Thread_range(int loc_n, int* first_p, int* last_p);
+void Min_range(dist_t loc_dist[], uint32_t known[], int first, int last,
+   int* u_p, dist_t* min_p);
+void Relax_range(weight_t row[], int u, dist_t u_dist, dist_t loc_dist[], 
+   int loc_pred[], uint32_t known[], int first, int last);
+void Heap_init(heap_t* heap, dist_t keys[], int loc_n);
+void Heap_free(heap_t* heap);
+void Heap_clear(heap_t* heap, dist_t keys[]);
+void Heap_update(heap_t* heap, int v);
+int  Heap_pop(heap_t* heap);
+int  Is_target(int v, int targets[], int n_targets);
+int* Parse_targets(char list[], int* n_targets_p);
+void Load_dense_tr(void* map, weight_t loc_tr[], int n, int loc_n, 
+   int my_first);
+void Read_dense_tr_all(MPI_File fh, weight_t loc_tr[], int n, int loc_n,
+   MPI_Datatype loc_col_mpi_t, int my_first);
+void Dijkstra_bidir(weight_t loc_mat[], weight_t loc_tr[], dist_t loc_dist[], 
+   int loc_pred[], int loc_succ[], int loc_n, int my_first, int src, int t, 
+   dist_t* mu_p, int* meet_p, MPI_Comm comm);
+void Print_bidir(int loc_pred[], int loc_succ[], int n, part_t* part, 
+   int src, int t, dist_t mu, int meet, int my_rank, MPI_Comm comm);
+void Print_stats(char fmt[], int n, int p, int my_rank, MPI_Comm comm);
+void Dijkstra_pipelined(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+   int loc_n, int my_first, int n, int src, int targets[], int n_targets, 
    MPI_Comm comm);
-void Print_paths(int loc_pred[], int n, int loc_n, int my_rank, 
+uint64_t Relax_min_dense(weight_t row[], int u, dist_t u_dist, 
+   dist_t loc_dist[], int loc_pred[], uint32_t known[], int loc_n, 
+   int my_first);
+MPI_File Create_results(char fname[], int n, int srcs[], int n_srcs, 
+   int my_rank, MPI_Comm comm);
+void Write_results(MPI_File fh, int rec, dist_t loc_dist[], int loc_pred[],
+   int n, int n_srcs, part_t* part, int my_rank);
+void Solve(weight_t loc_mat[], csr_t* loc_g, grid_t* grid, 
+   dist_t loc_dist[], int loc_pred[], int n, part_t* part, opts_t* opts, 
+   int my_rank, MPI_Comm comm);
+void Output_results(dist_t loc_dist[], int loc_pred[], int n, part_t* part,
+   opts_t* opts, int my_rank, MPI_Comm comm);
+int  Parse_query(char line[], opts_t* query, int n, edge_t** upd_p, 
+   int* n_upd_p);
+void Serve_queries(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+   int loc_pred[], int n, part_t* part, opts_t* opts, int my_rank, 
    MPI_Comm comm);
+int  Find_edge(csr_t* loc_g, int u, int v);
+int  Update_sssp(weight_t loc_mat[], csr_t* loc_g, edge_t upd[], int n_upd,
+   dist_t loc_dist[], int loc_pred[], int n, part_t* part, int src, 
+   int my_rank, MPI_Comm comm);
+void Build_grid(int n, int p, int my_rank, MPI_Comm comm, grid_t* grid,
+   part_t* part);
+void Free_grid(grid_t* grid);
+void Read_matrix_2d(weight_t loc_mat[], int n, grid_t* grid, int my_rank);
+void Load_block(void* map, weight_t loc_mat[], int n, int first_row, 
+   int loc_rows, int first_col, int loc_n);
+void Read_block_all(MPI_File fh, weight_t loc_mat[], int n, int first_row, 
+   int loc_rows, int first_col, int loc_n);
+void Dijkstra_2d(weight_t loc_mat[], dist_t loc_dist[], int loc_pred[], 
+   grid_t* grid, int n, int src, int targets[], int n_targets);
+void Read_matrix_shared(int n, part_t* part, MPI_Win win, 
+   MPI_Comm node_comm, int my_rank, MPI_Comm comm);
+void Build_hier(MPI_Comm comm);
+void Free_hier(void);
+void Allreduce_minloc(pair_t in[], pair_t out[], int count, MPI_Comm comm);
+int  Arena_init(arena_t* arena, size_t size);
+void* Arena_alloc(arena_t* arena, size_t size);
+void Arena_free(arena_t* arena);
+void Build_work(int n, int loc_n, int my_rank, MPI_Comm comm);
+void Free_work(void);
+int  Next_gen(void);
+void Dijkstra_fused(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+   int loc_n, int my_first, int n, int src, int targets[], int n_targets, 
+   MPI_Comm comm);
+int  Relax_min_fused(weight_t row[], int u, dist_t u_dist, 
+   dist_t loc_dist[], int loc_pred[], int loc_n);
+void Relax_min_range(weight_t row[], int u, dist_t u_dist, 
+   dist_t loc_dist[], int loc_pred[], int first, int last, int* u_p, 
+   dist_t* min_p);
+void Dijkstra_device(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+   int loc_n, int my_first, int n, int src, int targets[], int n_targets, 
+   MPI_Comm comm);
+void Update_device(weight_t loc_mat[], edge_t upd[], int n_upd, int loc_n,
+   int my_first);
+void Open_ckpt(char fname[], long steps, int restart, weight_t loc_mat[],
+   int n, int src, int targets[], int n_targets, int loc_n, int my_first, 
+   int my_rank, MPI_Comm comm);
+uint64_t Hash_graph(weight_t loc_mat[], int n, int loc_n, int my_first, 
+   MPI_Comm comm);
+uint64_t Hash_targets(int targets[], int n_targets);
+void Save_ckpt(dist_t loc_dist[], int loc_pred[], uint32_t known[], 
+   int64_t step, int64_t remaining);
+void Finish_ckpt(void);
+int  Restore_ckpt(dist_t loc_dist[], int loc_pred[], uint32_t known[], 
+   int* step_p, int* remaining_p);
+void Close_ckpt(void);
+void Index_tree(dist_t loc_dist[], int loc_pred[], int n, part_t* part, 
+   int src, tree_t* tree, int my_rank, MPI_Comm comm);
+void Build_tree(dist_t dist[], int pred[], int n, int src, tree_t* tree);
+void Free_tree(tree_t* tree);
+int  Write_tree(tree_t* tree, char fname[]);
+void Export_tree(dist_t loc_dist[], int loc_pred[], int n, part_t* part, 
+   int src, char fname[], int my_rank, MPI_Comm comm);
+int  On_path(tree_t* tree, int u, int v);
+void Print_tree_path(tree_t* tree, int v);
 
 /* -------------------------------------------------------------------------- */
 /* ------------------------------ main -------------------------------------- */
 
 int main(int argc, char* argv[]) {
-   int *loc_mat;
-   int n, loc_n, p, my_rank;
-   int *loc_dist, *loc_pred;
-   MPI_Comm comm;
-   MPI_Datatype blk_col_mpi_t;
+   weight_t *loc_mat = NULL, *loc_tr = NULL;
+   int *loc_succ, meet;
+   int n, loc_n, my_first, p, my_rank;
+   dist_t *loc_dist, *b_dist, mu;
+   int *loc_pred;
+   int *srcs, n_srcs, first, k, i, *b_pred, loc_rows, row_first;
+   void* map = NULL;
+   size_t map_size = 0;
+   graph_hdr_t hdr;
+   MPI_File fh = MPI_FILE_NULL, out_fh = MPI_FILE_NULL;
+   opts_t opts;
+   csr_t loc_g;
+   part_t part;
+   grid_t grid;
+   MPI_Comm comm, node_comm;
+   MPI_Win win;
+   MPI_Datatype blk_col_mpi_t, loc_col_mpi_t;
+   int provided;
+   double t0;
+   int64_t* cols_ptr;
 
-   MPI_Init(&argc, &argv);
+   /* Only the master thread of each process calls MPI */
+   MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
    comm = MPI_COMM_WORLD;
    MPI_Comm_size(comm, &p);
    MPI_Comm_rank(comm, &my_rank);
+   if (my_rank == 0) setvbuf(stdout, NULL, _IOFBF, OUT_BUF_SIZE);
+   Get_args(argc, argv, &opts, my_rank);
+#  ifdef _OPENMP
+   if (provided < MPI_THREAD_FUNNELED && my_rank == 0)
+      fprintf(stderr, "Warning:  MPI doesn't support MPI_THREAD_FUNNELED\n");
+#  endif
+
+   if (opts.hier) Build_hier(comm);
+
+   if (opts.conv_file != NULL) {
+      if (my_rank == 0) 
+         Convert_text(opts.conv_file, opts.sparse, opts.pack);
+      MPI_Finalize();
+      return 0;
+   }
    
-   n = Read_n(my_rank, comm);
-   loc_n = n/p;
-   loc_mat = malloc(n*loc_n*sizeof(int));
-   loc_dist = malloc(loc_n*sizeof(int));
-   loc_pred = malloc(loc_n*sizeof(int));
-   
-   /* Build the special MPI_Datatype before doing matrix I/O */
-   blk_col_mpi_t = Build_blk_col_type(n, loc_n);
+   if (opts.in_file != NULL) {
+      TIC(t0);
+      if (opts.mpi_io)
+         Open_graph(opts.in_file, &hdr, &fh, comm);
+      else
+         map = Map_graph(opts.in_file, &hdr, &map_size, comm);
+      TOC(t0, T_LOAD);
+      n = hdr.n;
+      opts.sparse = (hdr.layout != LAYOUT_DENSE);
+   } else {
+      n = Read_n(my_rank, comm);
+   }
+   Check_for_error(!(opts.bidir && opts.sparse), 
+         "-B is only available in dense mode", comm);
+   Check_for_error(!(opts.balance && !opts.sparse), 
+         "-P is only available in sparse mode", comm);
+   Check_for_error(!(opts.pipelined && opts.sparse), 
+         "-O is only available in dense mode", comm);
+   Check_for_error(!(opts.grid2d && opts.sparse), 
+         "-2 is only available in dense mode", comm);
+   Check_for_error(!(opts.shared && opts.sparse), 
+         "-W is only available in dense mode", comm);
+   Check_for_error(!(opts.fused && opts.sparse), 
+         "-F is only available in dense mode", comm);
+   Check_for_error(!(opts.device && opts.sparse), 
+         "-G is only available in dense mode", comm);
+   Check_for_error(!(opts.ckpt_file != NULL && opts.sparse), 
+         "-C is only available in dense mode", comm);
+   Check_for_error(opts.src < n && (opts.n_targets == 0 
+            || opts.targets[opts.n_targets-1] < n), 
+         "Source and targets must be less than n", comm);
+   Build_part(n, p, &part);
+   if (opts.balance && map != NULL) {
+      Balance_part(&part, (int64_t*) ((char*) map + sizeof(graph_hdr_t)));
+   } else if (opts.balance && fh != MPI_FILE_NULL) {
+      cols_ptr = Read_cols_ptr_all(fh, n);
+      Balance_part(&part, cols_ptr);
+      free(cols_ptr);
+   }
+   if (opts.grid2d) {
+      /* part becomes the layout of the output.  See note 20. */
+      Free_part(&part);
+      Build_grid(n, p, my_rank, comm, &grid, &part);
+   }
+   loc_n = part.counts[my_rank];
+   my_first = part.first[my_rank];
+
+   /* Read_edges and Read_matrix time their own phases */
+   TIC(t0);
+   if (opts.sparse) {
+      if (fh != MPI_FILE_NULL)
+         Read_csr_all(fh, &hdr, &loc_g, loc_n, my_first);
+      else if (map != NULL)
+         Load_csr(map, &hdr, &loc_g, loc_n, my_first);
+      else
+         Read_edges(&loc_g, &part, opts.balance, opts.pack, my_rank, 
+               comm);
+
+      /* Read_edges may have moved the block boundaries */
+      loc_n = part.counts[my_rank];
+      my_first = part.first[my_rank];
+   } else if (opts.grid2d) {
+      loc_n = grid.cols.counts[grid.my_col];
+      my_first = grid.cols.first[grid.my_col];
+      loc_rows = grid.rows.counts[grid.my_row];
+      row_first = grid.rows.first[grid.my_row];
+      loc_mat = malloc((size_t) loc_rows*loc_n*sizeof(weight_t));
+      if (fh != MPI_FILE_NULL)
+         Read_block_all(fh, loc_mat, n, row_first, loc_rows, my_first, 
+               loc_n);
+      else if (map != NULL)
+         Load_block(map, loc_mat, n, row_first, loc_rows, my_first, loc_n);
+      else
+         Read_matrix_2d(loc_mat, n, &grid, my_rank);
+   } else {
+      if (opts.shared) {
+         MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank, 
+               MPI_INFO_NULL, &node_comm);
+         MPI_Win_allocate_shared((MPI_Aint) n*loc_n*sizeof(weight_t),
+               sizeof(weight_t), MPI_INFO_NULL, node_comm, &loc_mat, &win);
+      } else {
+         loc_mat = malloc((size_t) n*loc_n*sizeof(weight_t));
+      }
 
-   Read_matrix(loc_mat, n, loc_n, blk_col_mpi_t, my_rank, comm);
+      /* Build the special MPI_Datatypes before doing matrix I/O */
+      blk_col_mpi_t = Build_blk_col_type(n);
+      loc_col_mpi_t = Build_loc_col_type(n, loc_n);
+      if (opts.bidir) loc_tr = malloc((size_t) n*loc_n*sizeof(weight_t));
+
+      if (fh != MPI_FILE_NULL) {
+         Read_dense_all(fh, loc_mat, n, loc_n, my_first);
+         if (opts.bidir)
+            Read_dense_tr_all(fh, loc_tr, n, loc_n, loc_col_mpi_t, my_first);
+      } else if (map != NULL) {
+         Load_dense(map, loc_mat, n, loc_n, my_first);
+         if (opts.bidir) Load_dense_tr(map, loc_tr, n, loc_n, my_first);
+      } else if (opts.shared) {
+         Read_matrix_shared(n, &part, win, node_comm, my_rank, comm);
+      } else {
+         Read_matrix(loc_mat, loc_tr, n, &part, blk_col_mpi_t, 
+               loc_col_mpi_t, opts.pack, my_rank, comm);
+      }
    
-   #ifdef DEBUG
-      Print_local_matrix(loc_mat, n, loc_n, my_rank);
-      Print_matrix(loc_mat, n, loc_n, blk_col_mpi_t, my_rank, comm);
-   #endif
-
-   Dijkstra(loc_mat, loc_dist, loc_pred, loc_n, my_rank, n, comm);
-   Print_dists(loc_dist, n, loc_n, my_rank, comm);
-   Print_paths(loc_pred, n, loc_n, my_rank, comm);
+      #ifdef DEBUG
+         Print_local_matrix(loc_mat, n, loc_n, my_rank);
+         Print_matrix(loc_mat, n, &part, blk_col_mpi_t, loc_col_mpi_t, 
+               my_rank, comm);
+      #endif
+
+      /* Frees the MPI Data Types*/
+      MPI_Type_free(&blk_col_mpi_t);
+      MPI_Type_free(&loc_col_mpi_t);
+   }
+   if (opts.in_file != NULL) TOC(t0, T_LOAD);
+   Build_work(n, loc_n, my_rank, comm);
+   loc_dist = work.loc_dist;
+   loc_pred = work.loc_pred;
+   if (opts.ckpt_file != NULL)
+      Open_ckpt(opts.ckpt_file, opts.ckpt_steps, opts.restart, loc_mat, n,
+            opts.src, opts.targets, opts.n_targets, loc_n, my_first, 
+            my_rank, comm);
+
+   /* The block column and the solution stay on the device.  See */
+   /* note 25.                                                    */
+#  ifdef _OPENMP
+#  pragma omp target enter data if (opts.device) \
+      map(to: loc_mat[0:(size_t) n*loc_n]) \
+      map(alloc: loc_dist[0:loc_n], loc_pred[0:loc_n])
+#  endif
+
+   if (opts.src_file != NULL) {
+      /* Solve for the sources opts.batch_k at a time */
+      srcs = Read_sources(opts.src_file, n, &n_srcs, my_rank, comm);
+      if (opts.out_file != NULL)
+         out_fh = Create_results(opts.out_file, n, srcs, n_srcs, my_rank,
+               comm);
+      b_dist = malloc((size_t) opts.batch_k*loc_n*sizeof(dist_t));
+      b_pred = malloc((size_t) opts.batch_k*loc_n*sizeof(int));
+      for (first = 0; first < n_srcs; first += opts.batch_k) {
+         k = (n_srcs - first < opts.batch_k) ? n_srcs - first : opts.batch_k;
+         Dijkstra_batch(loc_mat, opts.sparse ? &loc_g : NULL, &srcs[first], 
+               k, b_dist, b_pred, loc_n, my_first, n, comm);
+         TIC(t0);
+         for (i = 0; i < k; i++) {
+            if (out_fh != MPI_FILE_NULL) {
+               Write_results(out_fh, first+i, &b_dist[(size_t) i*loc_n], 
+                     &b_pred[(size_t) i*loc_n], n, n_srcs, &part, my_rank);
+            } else {
+               Print_dists(&b_dist[(size_t) i*loc_n], n, &part, 
+                     srcs[first+i], NULL, 0, my_rank, comm);
+               Print_paths(&b_pred[(size_t) i*loc_n], n, &part, 
+                     srcs[first+i], 
+                     NULL, 0, my_rank, comm);
+            }
+         }
+         TOC(t0, T_OUTPUT);
+      }
+      free(srcs);
+      free(b_dist);
+      free(b_pred);
+   } else if (opts.bidir) {
+      loc_succ = malloc(loc_n*sizeof(int));
+      Dijkstra_bidir(loc_mat, loc_tr, loc_dist, loc_pred, loc_succ, loc_n,
+            my_first, opts.src, opts.targets[0], &mu, &meet, comm);
+      TIC(t0);
+      Print_bidir(loc_pred, loc_succ, n, &part, opts.src, opts.targets[0], 
+            mu, meet, my_rank, comm);
+      TOC(t0, T_OUTPUT);
+      free(loc_succ);
+      free(loc_tr);
+   } else if (opts.query_file != NULL) {
+      Serve_queries(loc_mat, opts.sparse ? &loc_g : NULL, loc_dist, 
+            loc_pred, n, &part, &opts, my_rank, comm);
+   } else {
+      Solve(loc_mat, opts.sparse ? &loc_g : NULL, 
+            opts.grid2d ? &grid : NULL, loc_dist, loc_pred, n, &part, 
+            &opts, my_rank, comm);
+      TIC(t0);
+      Output_results(loc_dist, loc_pred, n, &part, &opts, my_rank, comm);
+      TOC(t0, T_OUTPUT);
+   }
+   if (opts.stats_fmt != NULL) 
+      Print_stats(opts.stats_fmt, n, p, my_rank, comm);
    
    /* Frees malloc'd space */
-   free(loc_mat);
-   free(loc_dist);
-   free(loc_pred);
-
-   /* Frees the MPI Data Type*/
-   MPI_Type_free(&blk_col_mpi_t);
+#  ifdef _OPENMP
+#  pragma omp target exit data if (opts.device) \
+      map(delete: loc_mat[0:(size_t) n*loc_n], loc_dist[0:loc_n], \
+            loc_pred[0:loc_n])
+#  endif
+   if (opts.sparse) {
+      Free_csr(&loc_g);
+   } else if (opts.shared) {
+      MPI_Win_free(&win);
+      MPI_Comm_free(&node_comm);
+   } else {
+      free(loc_mat);
+   }
+   Free_work();
+   free(opts.targets);
+   Free_part(&part);
+   if (opts.grid2d) Free_grid(&grid);
+   if (map != NULL) munmap(map, map_size);
+   if (fh != MPI_FILE_NULL) MPI_File_close(&fh);
+   if (out_fh != MPI_FILE_NULL) MPI_File_close(&out_fh);
+   if (opts.hier) Free_hier();
+   if (opts.ckpt_file != NULL) Close_ckpt();
 
    MPI_Finalize();
    return 0;
@@ -123,76 +1087,274 @@ int main(int argc, char* argv[]) {
  */
 int Read_n(int my_rank, MPI_Comm comm) {
    int n;
+   double t0;
 
-   if (my_rank == 0)
+   TIC(t0);
+   if (my_rank == 0) {
       printf("Please enter the number of vertices in your matrix\n");
       scanf("%d", &n);
+   }
    MPI_Bcast(&n, 1, MPI_INT, 0, comm);
+   COUNT_COLL(sizeof(int));
+   TOC(t0, T_READ_N);
    return n;
 }  /* Read_n */
 
 
 /*---------------------------------------------------------------------
  * Function:  Build_blk_col_type
- * Purpose:   Build an MPI_Datatype that represents a block column of
- *            a matrix
- * In args:   n:  number of rows in the matrix and the block column
- *            loc_n = n/p:  number cols in the block column
- * Ret val:   blk_col_mpi_t:  MPI_Datatype that represents a block
- *            column
- */
-MPI_Datatype Build_blk_col_type(int n, int loc_n) {
-   MPI_Aint lb, extent;
-   MPI_Datatype block_mpi_t;
-   MPI_Datatype first_bc_mpi_t;
-   MPI_Datatype blk_col_mpi_t;
-
-   MPI_Type_contiguous(loc_n, MPI_INT, &block_mpi_t);
-   MPI_Type_get_extent(block_mpi_t, &lb, &extent);
-
-   MPI_Type_vector(n, loc_n, n, MPI_INT, &first_bc_mpi_t);
-   MPI_Type_create_resized(first_bc_mpi_t, lb, extent,
-         &blk_col_mpi_t);
-   MPI_Type_commit(&blk_col_mpi_t);
-
-   MPI_Type_free(&block_mpi_t);
-   MPI_Type_free(&first_bc_mpi_t);
-
-   return blk_col_mpi_t;
+ * Purpose:   Build an MPI_Datatype that represents one column of a
+ *            matrix.  Its extent is one int, so a block column is
+ *            counts[q] of them starting at displacement first[q].
+ * In args:   n:  number of rows and columns in the matrix
+ * Ret val:   blk_col_mpi_t:  MPI_Datatype that represents a column
+ */
+MPI_Datatype Build_blk_col_type(int n) {
+   return Build_loc_col_type(n, n);
 }  /* Build_blk_col_type */
 
 /*---------------------------------------------------------------------
  * Function:  Read_matrix
- * Purpose:   Read in an nxn matrix of ints on process 0, and
+ * Purpose:   Read in an nxn matrix of weights on process 0, and
  *            distribute it among the processes so that each
- *            process gets a block column with n rows and n/p
- *            columns
+ *            process gets a block column with n rows and 
+ *            part->counts[my_rank] columns
  * In args:   n:  the number of rows in the matrix and the submatrices
- *            loc_n = n/p:  the number of columns in the submatrices
+ *            part:  the columns owned by each process
  *            blk_col_mpi_t:  the MPI_Datatype used on process 0
+ *            loc_col_mpi_t:  the MPI_Datatype used to receive loc_mat
+ *               and loc_tr
+ *            pack:  send only the finite entries of each block column,
+ *               packed (note 26)
  *            my_rank:  the caller's rank in comm
  *            comm:  Communicator consisting of all the processes
- * Out arg:   loc_mat:  the calling process' submatrix (needs to be 
+ * Out args:  loc_mat:  the calling process' submatrix (needs to be 
  *               allocated by the caller)
+ *            loc_tr:  if it isn't NULL, the calling process' block
+ *               column of the transpose (note 11)
  */
-void Read_matrix(int loc_mat[], int n, int loc_n, 
-      MPI_Datatype blk_col_mpi_t, int my_rank, MPI_Comm comm) {
-   int* mat = NULL, i, j;
+void Read_matrix(weight_t loc_mat[], weight_t loc_tr[], int n, part_t* part,
+      MPI_Datatype blk_col_mpi_t, MPI_Datatype loc_col_mpi_t, int pack,
+      int my_rank, MPI_Comm comm) {
+   weight_t* mat = NULL;
+   int *row_counts = NULL, *row_displs = NULL, i, j, q;
+   int loc_n = part->counts[my_rank];
+   double t0;
 
+   TIC(t0);
    if (my_rank == 0) {
-      mat = malloc(n*n*sizeof(int));
+      mat = malloc((size_t) n*n*sizeof(weight_t));
       for (i = 0; i < n; i++)
          for (j = 0; j < n; j++)
-            scanf("%d", &mat[i*n + j]);
+            scanf("%" WEIGHT_SCN, &mat[(size_t) i*n + j]);
    }
+   TOC(t0, T_PARSE);
 
-   MPI_Scatter(mat, 1, blk_col_mpi_t,
-           loc_mat, n*loc_n, MPI_INT, 0, comm);
+   TIC(t0);
+   if (pack) {
+      Scatter_packed(mat, loc_mat, n, part, 0, my_rank, comm);
+      if (loc_tr != NULL)
+         Scatter_packed(mat, loc_tr, n, part, 1, my_rank, comm);
+   } else {
+      MPI_Scatterv(mat, part->counts, part->first, blk_col_mpi_t,
+              loc_mat, loc_n, loc_col_mpi_t, 0, comm);
+      COUNT_COLL((long long) n*loc_n*sizeof(weight_t));
+   }
+
+   /* Block rows are contiguous, loc_col_mpi_t transposes them */
+   if (loc_tr != NULL && !pack) {
+      if (my_rank == 0) {
+         row_counts = malloc(part->p*sizeof(int));
+         row_displs = malloc(part->p*sizeof(int));
+         for (q = 0; q < part->p; q++) {
+            row_counts[q] = n*part->counts[q];
+            row_displs[q] = n*part->first[q];
+         }
+      }
+      MPI_Scatterv(mat, row_counts, row_displs, WEIGHT_MPI, 
+            loc_tr, loc_n, loc_col_mpi_t, 0, comm);
+      COUNT_COLL((long long) n*loc_n*sizeof(weight_t));
+      free(row_counts);
+      free(row_displs);
+   }
+   TOC(t0, T_SCATTER);
 
    if (my_rank == 0) free(mat);
 }  /* Read_matrix */
 
 
+/*---------------------------------------------------------------------
+ * Function:  Put_varint
+ * Purpose:   Append x to a packed buffer as a varint (note 26),
+ *            growing the buffer if needed
+ */
+static void Put_varint(pack_t* pk, uint64_t x) {
+   if (pk->size + VARINT_MAX > pk->max_size) {
+      pk->max_size = 2*pk->max_size + VARINT_MAX + sizeof(weight_t);
+      pk->bytes = realloc(pk->bytes, pk->max_size);
+   }
+   while (x >= 0x80) {
+      pk->bytes[pk->size++] = (x & 0x7f) | 0x80;
+      x >>= 7;
+   }
+   pk->bytes[pk->size++] = x;
+}  /* Put_varint */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Get_varint
+ * Purpose:   Decode the varint at *pp and advance *pp past it
+ */
+static uint64_t Get_varint(const unsigned char** pp) {
+   const unsigned char* p = *pp;
+   uint64_t x = 0;
+   int shift = 0;
+
+   while (*p & 0x80) {
+      x |= (uint64_t) (*p++ & 0x7f) << shift;
+      shift += 7;
+   }
+   x |= (uint64_t) *p++ << shift;
+   *pp = p;
+   return x;
+}  /* Get_varint */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Put_weight
+ * Purpose:   Append w to a packed buffer:  a varint for the integer 
+ *            weight types, its bytes for float and double
+ */
+static void Put_weight(pack_t* pk, weight_t w) {
+#  if defined(WEIGHT_FLOAT) || defined(WEIGHT_DOUBLE)
+   if (pk->size + sizeof(weight_t) > pk->max_size) {
+      pk->max_size = 2*pk->max_size + VARINT_MAX + sizeof(weight_t);
+      pk->bytes = realloc(pk->bytes, pk->max_size);
+   }
+   memcpy(pk->bytes + pk->size, &w, sizeof(weight_t));
+   pk->size += sizeof(weight_t);
+#  else
+   Put_varint(pk, (uint64_t) w);
+#  endif
+}  /* Put_weight */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Get_weight
+ * Purpose:   Decode the weight at *pp and advance *pp past it
+ */
+static weight_t Get_weight(const unsigned char** pp) {
+#  if defined(WEIGHT_FLOAT) || defined(WEIGHT_DOUBLE)
+   weight_t w;
+
+   memcpy(&w, *pp, sizeof(weight_t));
+   *pp += sizeof(weight_t);
+   return w;
+#  else
+   return (weight_t) Get_varint(pp);
+#  endif
+}  /* Get_weight */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Scatter_packed
+ * Purpose:   Send each process its block column of mat, or of its
+ *            transpose, as a packed list of the finite entries 
+ *            (note 26)
+ * In args:   mat:  the n x n matrix on process 0
+ *            n:  the number of rows in the matrix
+ *            part:  the columns owned by each process
+ *            tr:  1 to send the block columns of the transpose
+ *            my_rank:  the caller's rank in comm
+ *            comm:  Communicator consisting of all the processes
+ * Out arg:   loc_mat:  the calling process' block column
+ */
+void Scatter_packed(weight_t mat[], weight_t loc_mat[], int n, 
+      part_t* part, int tr, int my_rank, MPI_Comm comm) {
+   pack_t pk = {0, 0, NULL};
+   int *counts = NULL, *displs = NULL, nbytes, q;
+   unsigned char* bytes;
+
+   if (my_rank == 0) {
+      counts = malloc(part->p*sizeof(int));
+      displs = malloc(part->p*sizeof(int));
+      for (q = 0; q < part->p; q++) {
+         displs[q] = pk.size;
+         Pack_block(&pk, mat, n, part->first[q], part->counts[q], tr);
+         counts[q] = pk.size - displs[q];
+      }
+   }
+
+   MPI_Scatter(counts, 1, MPI_INT, &nbytes, 1, MPI_INT, 0, comm);
+   bytes = malloc(nbytes);
+   MPI_Scatterv(pk.bytes, counts, displs, MPI_BYTE, bytes, nbytes, 
+         MPI_BYTE, 0, comm);
+   COUNT_COLL(sizeof(int));
+   COUNT_COLL(nbytes);
+   Unpack_block(bytes, nbytes, loc_mat, 
+         (size_t) n*part->counts[my_rank]);
+
+   free(bytes);
+   free(pk.bytes);
+   free(counts);
+   free(displs);
+}  /* Scatter_packed */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Pack_block
+ * Purpose:   Append the finite entries of a block column of mat, or 
+ *            of its transpose, to a packed buffer.  Each entry is 
+ *            the number of entries skipped since the last one and 
+ *            its weight.
+ * In args:   mat:  the n x n matrix
+ *            n:  the number of rows in the matrix
+ *            first:  the first column of the block column
+ *            count:  the number of columns in the block column
+ *            tr:  1 to use the transpose of mat
+ * In/out:    pk:  the packed buffer
+ */
+void Pack_block(pack_t* pk, weight_t mat[], int n, int first, int count,
+      int tr) {
+   size_t i, j, next = 0;
+   weight_t w;
+
+   for (i = 0; i < n; i++)
+      for (j = 0; j < count; j++) {
+         w = tr ? mat[(first + j)*n + i] : mat[i*n + first + j];
+         if (w < NO_EDGE) {
+            Put_varint(pk, i*count + j - next);
+            Put_weight(pk, w);
+            next = i*count + j + 1;
+         }
+      }
+}  /* Pack_block */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Unpack_block
+ * Purpose:   Decode a block column packed by Pack_block
+ * In args:   bytes:  the packed entries
+ *            nbytes:  the number of bytes
+ *            size:  the number of entries in the block column
+ * Out arg:   loc_mat:  the block column.  Entries that weren't 
+ *               packed are NO_EDGE.
+ */
+void Unpack_block(const unsigned char bytes[], int nbytes, 
+      weight_t loc_mat[], size_t size) {
+   const unsigned char* p = bytes;
+   size_t i;
+
+   for (i = 0; i < size; i++)
+      loc_mat[i] = NO_EDGE;
+   i = 0;
+   while (p < bytes + nbytes) {
+      i += Get_varint(&p);
+      loc_mat[i++] = Get_weight(&p);
+   }
+}  /* Unpack_block */
+
+
 /*---------------------------------------------------------------------
  * Function:  Print_local_matrix
  * Purpose:   Store a process' submatrix as a string and print the
@@ -204,7 +1366,7 @@ void Read_matrix(int loc_mat[], int n, int loc_n,
  *            loc_n:  the number of cols in the submatrix
  *            my_rank:  the calling process' rank
  */
-void Print_local_matrix(int loc_mat[], int n, int loc_n, int my_rank) {
+void Print_local_matrix(weight_t loc_mat[], int n, int loc_n, int my_rank) {
    char temp[MAX_STRING];
    char *cp = temp;
    int i, j;
@@ -213,10 +1375,10 @@ void Print_local_matrix(int loc_mat[], int n, int loc_n, int my_rank) {
    cp = temp + strlen(temp);
    for (i = 0; i < n; i++) {
       for (j = 0; j < loc_n; j++) {
-         if (loc_mat[i*loc_n + j] == INFINITY)
+         if (loc_mat[(size_t) i*loc_n + j] >= NO_EDGE)
             sprintf(cp, " i ");
          else
-            sprintf(cp, "%2d ", loc_mat[i*loc_n + j]);
+            sprintf(cp, "%2" WEIGHT_FMT " ", loc_mat[(size_t) i*loc_n + j]);
          cp = temp + strlen(temp);
       }
       sprintf(cp, "\n");
@@ -233,26 +1395,30 @@ void Print_local_matrix(int loc_mat[], int n, int loc_n, int my_rank) {
  *            processes.
  * In args:   loc_mat:  the calling process' submatrix
  *            n:  number of rows in the matrix and the submatrices
- *            loc_n:  the number of cols in the submatrix
+ *            part:  the columns owned by each process
  *            blk_col_mpi_t:  MPI_Datatype used on process 0 to
- *               receive a process' submatrix
+ *               receive a column
+ *            loc_col_mpi_t:  MPI_Datatype used to send a column of
+ *               the submatrix
  *            my_rank:  the calling process' rank
  *            comm:  Communicator consisting of all the processes
  */
-void Print_matrix(int loc_mat[], int n, int loc_n,
-      MPI_Datatype blk_col_mpi_t, int my_rank, MPI_Comm comm) {
-   int* mat = NULL, i, j;
+void Print_matrix(weight_t loc_mat[], int n, part_t* part,
+      MPI_Datatype blk_col_mpi_t, MPI_Datatype loc_col_mpi_t, int my_rank,
+      MPI_Comm comm) {
+   weight_t* mat = NULL;
+   int i, j;
 
-   if (my_rank == 0) mat = malloc(n*n*sizeof(int));
-   MPI_Gather(loc_mat, n*loc_n, MPI_INT,
-         mat, 1, blk_col_mpi_t, 0, comm);
+   if (my_rank == 0) mat = malloc((size_t) n*n*sizeof(weight_t));
+   MPI_Gatherv(loc_mat, part->counts[my_rank], loc_col_mpi_t,
+         mat, part->counts, part->first, blk_col_mpi_t, 0, comm);
    if (my_rank == 0) {
       for (i = 0; i < n; i++) {
          for (j = 0; j < n; j++)
-            if (mat[i*n + j] == INFINITY)
+            if (mat[(size_t) i*n + j] >= NO_EDGE)
                printf(" i ");
             else
-               printf("%2d ", mat[i*n + j]);
+               printf("%2" WEIGHT_FMT " ", mat[(size_t) i*n + j]);
          printf("\n");
       }
       free(mat);
@@ -264,105 +1430,162 @@ void Print_matrix(int loc_mat[], int n, int loc_n,
  * Purpose:     Apply Dijkstra's algorithm to the matrix mat
  * In args:     mat: mat[] = submatrix from each process
  *              loc_n = size of loc_dist[] and loc_pred[]
- *              my_rank = rank of process
+ *              my_first = the first vertex owned by the process
+ *              src = the source vertex
+ *              radius = stop once the global minimum is greater,
+ *                 or INFINITY (note 27)
+ *              targets = sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets = the number of targets
  *              MPI_Comm = MPI Communicator
  * In/Out args: loc_dist: loc_dist[] = subarray of distances
  *              loc_pred: loc_pred[] = subarray of predecessors
  *         
  */
-void Dijkstra(int mat[], int loc_dist[], int loc_pred[], int loc_n, int my_rank,
-   int n, MPI_Comm comm) {
-   int i, loc_u, u, v, *known, new_dist;
+void Dijkstra(weight_t mat[], dist_t loc_dist[], int loc_pred[], int loc_n, 
+   int my_first, int n, int src, dist_t radius, int targets[], 
+   int n_targets, MPI_Comm comm) {
+   int i = 1, loc_u, u, v;
+   pair_t my_min, glbl_min;
+   uint32_t* known;
+   double t0;
 
-   /* known[v] = true, if the shortest path 0->v is known */
-   /* known[v] = false, otherwise                         */
-   known = malloc(loc_n*sizeof(int));
+   /* Without targets remaining never reaches 0 */
+   int remaining = (targets != NULL) ? n_targets : n;
 
-   for (v = 0; v < loc_n; v++) {
-      loc_dist[v] = mat[0*loc_n + v];
-      loc_pred[v] = 0;
-      known[v] = 0;
-   }
+   /* Bit v of known is 1, if the shortest path src->v is known */
+   /* and 0 otherwise.  See notes 8 and 23.                     */
+   known = work.known;
+   memset(known, 0, KNOWN_WORDS(loc_n)*sizeof(uint32_t));
 
-   if (my_rank == 0) {
-      known[0] = 1;
+   /* With -r the loop picks up at the step that was saved */
+   if (!Restore_ckpt(loc_dist, loc_pred, known, &i, &remaining)) {
+#     ifdef _OPENMP
+#     pragma omp parallel for if (loc_n >= OMP_MIN_N)
+#     endif
+      for (v = 0; v < loc_n; v++) {
+         loc_dist[v] = EDGE_DIST(mat[(size_t) src*loc_n + v]);
+         loc_pred[v] = src;
+      }
+
+      if (OWNS(my_first, loc_n, src)) {
+         loc_dist[src - my_first] = 0;
+         SET_KNOWN(known, src - my_first);
+         stats.settled++;
+      }
+      if (Is_target(src, targets, n_targets)) remaining--;
    }
 
    /* On each pass find an additional vertex */
-   /* whose distance to 0 is known           */
-   for (i = 1; i < n; i++) {
+   /* whose distance to src is known         */
+   for ( ; i < n && remaining > 0; i++) {
 
       /* Finds the minimum distance of each dist subarray */
-      loc_u = Find_min_dist(loc_dist, known, loc_n, my_rank, comm);
+      TIC(t0);
+      loc_u = Find_min_dist_bits(loc_dist, known, loc_n);
 
-      int my_min[2], glbl_min[2];
-
-      if (loc_u < INFINITY) {
-         my_min[0] = loc_dist[loc_u];
-         my_min[1] = loc_u + my_rank * loc_n;
+      if (loc_u < NO_VERTEX) {
+         my_min.dist = loc_dist[loc_u];
+         my_min.v = loc_u + my_first;
       } else {
-         my_min[0] = INFINITY;
-         my_min[1] = INFINITY;
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
       }
 
+      TOC(t0, T_MIN);
+
       /* Finds the minimum distance between each processes' subarray */
-      MPI_Allreduce(my_min, glbl_min, 1, MPI_2INT, MPI_MINLOC, comm);
+      TIC(t0);
+      Allreduce_minloc(&my_min, &glbl_min, 1, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
 
       /* Stores the global min dist and where it was found */
-      int min_dist = glbl_min[0];
-      u = glbl_min[1];
+      dist_t min_dist = glbl_min.dist;
+      u = glbl_min.v;
+
+      /* The rest of the vertices can't be reached, or are farther */
+      /* than radius                                               */
+      if (min_dist >= INFINITY || min_dist > radius) break;
 
       /* Sets known to 1 for appropriate processor */
-      if(u/loc_n == my_rank) {
+      if(OWNS(my_first, loc_n, u)) {
 
-         loc_u = u % loc_n;
+         loc_u = u - my_first;
 
-         known[loc_u] = 1;
+         SET_KNOWN(known, loc_u);
+         stats.settled++;
       }
 
+      /* Stops once all of the targets are known */
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+
       /* Checks to see if new min is less than existing distance */
-      for (v = 0; v < loc_n; v++) {
-         if (!known[v]) {
-            new_dist = min_dist + mat[u*loc_n + v];
-            if (new_dist < loc_dist[v]) {
-               loc_dist[v] = new_dist;
-               loc_pred[v] = u;
-            }
-         }
-      }
-   } /* for i */
+      TIC(t0);
+      Relax_dense(&mat[(size_t) u*loc_n], u, min_dist, loc_dist, loc_pred, 
+            known, loc_n);
+      TOC(t0, T_RELAX);
 
-   free(known);
+      /* Starts saving the state after this pass.  See note 28. */
+      if (ckpt.fh != MPI_FILE_NULL && (i + 1) % ckpt.steps == 0)
+         Save_ckpt(loc_dist, loc_pred, known, i + 1, remaining);
+   } /* for i */
+   if (ckpt.fh != MPI_FILE_NULL) Finish_ckpt();
 }  /* Dijkstra */ 
 
 /*-------------------------------------------------------------------
  * Function:    Find_min_dist
- * Purpose:     Find the vertex u with minimum distance to 0
+ * Purpose:     Find the vertex u with minimum distance to src
  *              (loc_dist[u]) among the vertices whose distance 
- *              to 0 is not known.
+ *              to src is not known.
  * In args:     loc_dist: loc_dist[v] = current estimate of distance
- *                 0->v
- *              loc_known: whether the minimum distance 0-> is
+ *                 src->v
+ *              loc_known: whether the minimum distance src->v is
  *                 known
  *              loc_n:  the total number of vertices in each process
- * Ret val:     The vertex loc_u whose distance to 0, loc_dist[u]
+ * Ret val:     The vertex loc_u whose distance to src, loc_dist[u]
  *              is a minimum among vertices whose distance
- *              to 0 is not known.
+ *              to src is not known, or NO_VERTEX if they're all
+ *              unreachable.
+ *
+ * Note:        With OpenMP each thread finds the minimum of its part
+ *              of loc_dist and the threads' results are combined in
+ *              a critical section.  Ties go to the smaller vertex, so
+ *              the result is the same as the serial loop's.
  */
-int Find_min_dist(int loc_dist[], int loc_known[], int loc_n, int my_rank, 
-   MPI_Comm comm) {
+int Find_min_dist(dist_t loc_dist[], int loc_known[], int loc_n) {
+
+   int loc_u = NO_VERTEX;
+   dist_t loc_min_dist = INFINITY;
 
-   int loc_v;
+#  ifdef _OPENMP
+#  pragma omp parallel if (loc_n >= OMP_MIN_N)
+#  endif
+   {
+      int loc_v;
+      int my_u = NO_VERTEX;
+      dist_t my_min_dist = INFINITY;
 
-   int loc_u = INFINITY;
-   int loc_min_dist = INFINITY;
-   for (loc_v = 0; loc_v < loc_n; loc_v++) {
-      if (!loc_known[loc_v]) {
-         if (loc_dist[loc_v] < loc_min_dist) {
-            loc_u = loc_v;
-            loc_min_dist = loc_dist[loc_v];
+#     ifdef _OPENMP
+#     pragma omp for nowait
+#     endif
+      for (loc_v = 0; loc_v < loc_n; loc_v++) {
+         if (!loc_known[loc_v]) {
+            if (loc_dist[loc_v] < my_min_dist) {
+               my_u = loc_v;
+               my_min_dist = loc_dist[loc_v];
+            }
          }
       }
+
+#     ifdef _OPENMP
+#     pragma omp critical
+#     endif
+      if (my_min_dist < loc_min_dist 
+            || (my_min_dist == loc_min_dist && my_u < loc_u)) {
+         loc_u = my_u;
+         loc_min_dist = my_min_dist;
+      }
    }
 
    return loc_u;
@@ -370,79 +1593,5199 @@ int Find_min_dist(int loc_dist[], int loc_known[], int loc_n, int my_rank,
 
    /*-------------------------------------------------------------------
  * Function:    Print_dists
- * Purpose:     Print the length of the shortest path from 0 to each
+ * Purpose:     Print the length of the shortest path from src to each
  *              vertex
  * In args:     n:  the number of vertices
- *              dist:  distances from 0 to each vertex v:  dist[v]
- *                 is the length of the shortest path 0->v
+ *              dist:  distances from src to each vertex v:  dist[v]
+ *                 is the length of the shortest path src->v
+ *              src:  the source vertex
+ *              targets:  sorted list of the vertices to print, or 
+ *                 NULL to print every vertex
+ *              n_targets:  the number of targets
  */
-void Print_dists(int loc_dist[], int n, int loc_n, int my_rank, 
-   MPI_Comm comm) {
+void Print_dists(dist_t loc_dist[], int n, part_t* part, int src, 
+      int targets[], int n_targets, int my_rank, MPI_Comm comm) {
    int v;
 
-   int* dist = NULL;
-
-   if (my_rank == 0) {
-      dist = malloc(n*sizeof(int));
-   }
+   /* work.dist is NULL except on process 0 */
+   dist_t* dist = work.dist;
 
-   MPI_Gather(loc_dist, loc_n, MPI_INT, dist, loc_n, MPI_INT, 0, comm);
+   MPI_Gatherv(loc_dist, part->counts[my_rank], DIST_MPI, dist, part->counts,
+         part->first, DIST_MPI, 0, comm);
+   COUNT_COLL(part->counts[my_rank]*sizeof(dist_t));
 
    if (my_rank == 0) {
-      printf("The distance from 0 to each vertex is:\n");
-      printf("  v    dist 0->v\n");
+      printf("The distance from %d to each vertex is:\n", src);
+      printf("  v    dist %d->v\n", src);
       printf("----   ---------\n");
                      
-      for (v = 1; v < n; v++)
-         printf("%3d       %4d\n", v, dist[v]);
+      for (v = 0; v < n; v++)
+         if (v != src && (targets == NULL || Is_target(v, targets, n_targets)))
+            printf("%3d       %4" DIST_FMT "\n", v, dist[v]);
       printf("\n");
-
-      free(dist);
    }
       
 } /* Print_dists */  
 
+/*-------------------------------------------------------------------
+ * Function:    Vertex_len
+ * Purpose:     Find the number of characters Print_paths uses for 
+ *              vertex v:  its digits and a blank
+ */
+static int Vertex_len(int v) {
+   int len = 2;
+
+   while (v >= 10) {
+      v /= 10;
+      len++;
+   }
+   return len;
+}  /* Vertex_len */
+
+/*-------------------------------------------------------------------
+ * Function:    Put_vertex
+ * Purpose:     Write vertex v and a blank so that they end just
+ *              before end
+ * Ret val:     The first character written
+ */
+static char* Put_vertex(char* end, int v) {
+   *--end = ' ';
+   do {
+      *--end = '0' + v % 10;
+      v /= 10;
+   } while (v > 0);
+   return end;
+}  /* Put_vertex */
+
 /*-------------------------------------------------------------------
  * Function:    Print_paths
- * Purpose:     Print the shortest path from 0 to each vertex
+ * Purpose:     Print the shortest path from src to each vertex
  * In args:     n:  the number of vertices
+ *              part:  the vertices owned by each process
  *              pred:  list of predecessors:  pred[v] = u if
- *                 u precedes v on the shortest path 0->v
+ *                 u precedes v on the shortest path src->v
+ *              src:  the source vertex
+ *              targets:  sorted list of the vertices to print, or 
+ *                 NULL to print every vertex
+ *              n_targets:  the number of targets
+ *
+ * Note:        len[v] is the number of characters in the path src->v,
+ *              or 0 if it hasn't been found yet.  It's found by 
+ *              walking pred up to the first vertex whose length is
+ *              known, so each length is only computed once.  Each
+ *              path is then written right to left into line.  See
+ *              note 17.
  */
-void Print_paths(int loc_pred[], int n, int loc_n, int my_rank, 
-   MPI_Comm comm) {
-   int v, w, *path, count, i;
+void Print_paths(int loc_pred[], int n, part_t* part, int src, 
+      int targets[], int n_targets, int my_rank, MPI_Comm comm) {
+   int v, w, top, *stack;
+   int64_t *len, max_len = 0;
+   char *line, *start;
 
-   int* pred = NULL;
+   /* work.pred is NULL except on process 0 */
+   int* pred = work.pred;
+
+   MPI_Gatherv(loc_pred, part->counts[my_rank], MPI_INT, pred, part->counts,
+         part->first, MPI_INT, 0, comm);
+   COUNT_COLL(part->counts[my_rank]*sizeof(int));
 
    if (my_rank == 0) {
-      pred = malloc(n*sizeof(int));
+      len = work.len;
+      stack = work.stack;
+      memset(len, 0, n*sizeof(int64_t));
+      len[src] = Vertex_len(src);
+      for (v = 0; v < n; v++) {
+         if (targets != NULL && !Is_target(v, targets, n_targets)) continue;
+         top = 0;
+         for (w = v; len[w] == 0; w = pred[w])
+            stack[top++] = w;
+         while (top > 0) {
+            w = stack[--top];
+            len[w] = len[pred[w]] + Vertex_len(w);
+         }
+         if (len[v] > max_len) max_len = len[v];
+      }
+      line = malloc(max_len + 1);
+      line[max_len] = '\n';
+
+      printf("The shortest path from %d to each vertex is:\n", src);
+      printf("  v     Path %d->v\n", src);
+      printf("----    ---------\n");
+      for (v = 0; v < n; v++) {
+         if (v == src) continue;
+         if (targets != NULL && !Is_target(v, targets, n_targets)) continue;
+         printf("%3d:    ", v);
+         start = &line[max_len];
+         for (w = v; w != src; w = pred[w])
+            start = Put_vertex(start, w);
+         start = Put_vertex(start, src);
+         fwrite(start, 1, len[v] + 1, stdout);
+      }
+
+      free(line);
+   }
+}  /* Print_paths */
+
+/*---------------------------------------------------------------------
+ * Function:  Get_args
+ * Purpose:   Process the command line
+ * In args:   argc, argv:  the command line
+ *            my_rank:  the calling process' rank
+ * Out arg:   opts:  the options selected on the command line
+ */
+void Get_args(int argc, char* argv[], opts_t* opts, int my_rank) {
+   int i;
+   double radius;
+
+   opts->sparse = 0;
+   opts->in_file = NULL;
+   opts->conv_file = NULL;
+   opts->mpi_io = 0;
+   opts->delta = 0;
+   opts->src_file = NULL;
+   opts->batch_k = BATCH_K;
+   opts->src = 0;
+   opts->targets = NULL;
+   opts->n_targets = 0;
+   opts->bidir = 0;
+   opts->stats_fmt = NULL;
+   opts->balance = 0;
+   opts->pipelined = 0;
+   opts->out_file = NULL;
+   opts->query_file = NULL;
+   opts->grid2d = 0;
+   opts->shared = 0;
+   opts->hier = 0;
+   opts->fused = 0;
+   opts->device = 0;
+   opts->pack = 0;
+   opts->tree_file = NULL;
+   opts->ckpt_file = NULL;
+   opts->ckpt_steps = CKPT_STEPS;
+   opts->restart = 0;
+   opts->radius = INFINITY;
+   opts->eps = 0;
+   for (i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "-s") == 0) {
+         opts->sparse = 1;
+      } else if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+         opts->in_file = argv[++i];
+      } else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+         opts->conv_file = argv[++i];
+      } else if (strcmp(argv[i], "-i") == 0) {
+         opts->mpi_io = 1;
+      } else if (strcmp(argv[i], "-D") == 0 && i+1 < argc 
+            && (opts->delta = strtod(argv[i+1], NULL)) > 0) {
+         i++;
+      } else if (strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+         opts->src_file = argv[++i];
+      } else if (strcmp(argv[i], "-k") == 0 && i+1 < argc 
+            && (opts->batch_k = strtol(argv[i+1], NULL, 10)) > 0) {
+         i++;
+      } else if (strcmp(argv[i], "-T") == 0 && i+1 < argc 
+            && (strcmp(argv[i+1], "json") == 0 
+               || strcmp(argv[i+1], "csv") == 0)) {
+         opts->stats_fmt = argv[++i];
+      } else if (strcmp(argv[i], "-x") == 0 && i+1 < argc) {
+         opts->tree_file = argv[++i];
+      } else if (strcmp(argv[i], "-C") == 0 && i+1 < argc) {
+         opts->ckpt_file = argv[++i];
+      } else if (strcmp(argv[i], "-I") == 0 && i+1 < argc 
+            && (opts->ckpt_steps = strtol(argv[i+1], NULL, 10)) > 0) {
+         i++;
+      } else if (strcmp(argv[i], "-r") == 0) {
+         opts->restart = 1;
+      } else if (strcmp(argv[i], "-R") == 0 && i+1 < argc 
+            && (radius = strtod(argv[i+1], NULL)) >= 0) {
+         opts->radius = (radius < INFINITY) ? radius : INFINITY;
+         i++;
+      } else if (strcmp(argv[i], "-E") == 0 && i+1 < argc 
+            && (opts->eps = strtod(argv[i+1], NULL)) > 0) {
+         i++;
+      } else if (strcmp(argv[i], "-z") == 0) {
+         opts->pack = 1;
+      } else if (strcmp(argv[i], "-G") == 0) {
+         opts->device = 1;
+      } else if (strcmp(argv[i], "-F") == 0) {
+         opts->fused = 1;
+      } else if (strcmp(argv[i], "-H") == 0) {
+         opts->hier = 1;
+      } else if (strcmp(argv[i], "-W") == 0) {
+         opts->shared = 1;
+      } else if (strcmp(argv[i], "-2") == 0) {
+         opts->grid2d = 1;
+      } else if (strcmp(argv[i], "-q") == 0 && i+1 < argc) {
+         opts->query_file = argv[++i];
+      } else if (strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+         opts->out_file = argv[++i];
+      } else if (strcmp(argv[i], "-O") == 0) {
+         opts->pipelined = 1;
+      } else if (strcmp(argv[i], "-P") == 0) {
+         opts->balance = 1;
+      } else if (strcmp(argv[i], "-B") == 0) {
+         opts->bidir = 1;
+      } else if (strcmp(argv[i], "-S") == 0 && i+1 < argc 
+            && (opts->src = strtol(argv[i+1], NULL, 10)) >= 0) {
+         i++;
+      } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc 
+            && opts->targets == NULL
+            && (opts->targets = Parse_targets(argv[i+1], 
+                  &opts->n_targets)) != NULL) {
+         i++;
+      } else {
+         if (my_rank == 0) Usage(argv[0]);
+         MPI_Finalize();
+         exit(-1);
+      }
+   }
+
+   if (opts->src_file != NULL && (opts->delta > 0 || opts->src != 0
+            || opts->targets != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-b can't be used with -D, -S or -t\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->query_file != NULL && (opts->src_file != NULL || opts->bidir
+            || opts->src != 0 || opts->targets != NULL 
+            || opts->out_file != NULL || opts->tree_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-q can't be used with -b or -B, and -S, -t, -o "
+               "and -x are given with each query\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->grid2d && (opts->delta > 0 || opts->bidir || opts->pipelined
+            || opts->src_file != NULL || opts->query_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-2 can't be used with -D, -B, -O, -b or -q\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->shared && (opts->bidir || opts->grid2d)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-W can't be used with -B or -2\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->bidir && (opts->n_targets != 1 || opts->delta > 0
+            || opts->out_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-B needs exactly one target and can't be used "
+               "with -D or -o\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->pipelined && (opts->delta > 0 || opts->bidir 
+            || opts->src_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-O can't be used with -D, -B or -b\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->device && (opts->delta > 0 || opts->bidir || opts->pipelined
+            || opts->grid2d || opts->fused || opts->src_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-G can't be used with -D, -B, -O, -2, -F or "
+               "-b\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->fused && (opts->delta > 0 || opts->bidir || opts->pipelined
+            || opts->grid2d || opts->src_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-F can't be used with -D, -B, -O, -2 or -b\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if ((opts->radius < INFINITY || opts->eps > 0) && (opts->grid2d 
+            || opts->bidir || opts->src_file != NULL || opts->pipelined 
+            || opts->fused || opts->device)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-R and -E can't be used with -2, -B, -b, -O, -F "
+               "or -G\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->eps > 0 && opts->delta > 0) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-E can't be used with -D\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->ckpt_file != NULL && (opts->delta > 0 || opts->eps > 0
+            || opts->bidir || opts->pipelined || opts->grid2d || opts->fused
+            || opts->device || opts->src_file != NULL 
+            || opts->query_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-C can't be used with -D, -E, -B, -O, -2, -F, -G, "
+               "-b or -q\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->tree_file != NULL && (opts->targets != NULL || opts->bidir
+            || opts->src_file != NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-x needs the whole tree, so it can't be used "
+               "with -t, -B or -b\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+   if (opts->restart && (opts->ckpt_file == NULL || opts->in_file == NULL)) {
+      if (my_rank == 0) {
+         fprintf(stderr, "-r needs -C and a binary graph file (-f)\n");
+         Usage(argv[0]);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+
+#  ifndef SETTLED_BIT
+   /* The settled bit is the sign bit of an integer distance */
+   if (opts->fused) {
+      if (my_rank == 0)
+         fprintf(stderr, "-F needs integer distances (note 24)\n");
+      MPI_Finalize();
+      exit(-1);
    }
+#  endif
+
+#  ifndef INT_DIST
+   /* KEY packs a 32-bit distance */
+   if (opts->pipelined || opts->device) {
+      if (my_rank == 0)
+         fprintf(stderr, "-O and -G need 32-bit distances (note 15)\n");
+      MPI_Finalize();
+      exit(-1);
+   }
+#  endif
+}  /* Get_args */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a message explaining how to run the program
+ * In arg:    prog_name:  the name of the executable
+ */
+void Usage(char prog_name[]) {
+   fprintf(stderr, "usage: mpiexec -n <p> %s [-s] [-f <graph> [-i]] "
+         "[-D <delta>]\n", prog_name);
+   fprintf(stderr, "          [-S <src>] [-t <targets> [-B]] "
+         "[-b <sources> [-k <K>]]\n");
+   fprintf(stderr, "          [-T json|csv] [-P] [-O] [-o <results>] "
+         "[-q <queries>]\n");
+   fprintf(stderr, "          [-2] [-W] [-H] [-F] [-G] [-z] [-R <radius>] "
+         "[-E <eps>]\n");
+   fprintf(stderr, "          [-C <checkpoint> [-I <steps>] [-r]] "
+         "[-x <tree>]\n");
+   fprintf(stderr, "       %s [-s [-z]] -c <graph> < <text input>\n", 
+         prog_name);
+   fprintf(stderr, "   -s:  read an edge list and use the sparse engine\n");
+   fprintf(stderr, "   -f:  load a binary graph file\n");
+   fprintf(stderr, "   -i:  load the graph file with collective MPI-IO\n");
+   fprintf(stderr, "   -D:  use delta-stepping with bucket width delta\n");
+   fprintf(stderr, "   -S:  find the shortest paths from src (0)\n");
+   fprintf(stderr, "   -t:  stop once the vertices in the list t1,t2,... "
+         "are settled\n");
+   fprintf(stderr, "   -B:  search from both ends for a single target\n");
+   fprintf(stderr, "   -T:  write timings and counters to stderr\n");
+   fprintf(stderr, "   -P:  balance the sparse blocks by edge count\n");
+   fprintf(stderr, "   -O:  overlap the minimum reduction with the local "
+         "search\n");
+   fprintf(stderr, "   -b:  solve from each vertex listed in sources\n");
+   fprintf(stderr, "   -k:  number of sources solved together (%d)\n",
+         BATCH_K);
+   fprintf(stderr, "   -o:  write the distances and predecessors to a "
+         "binary file\n");
+   fprintf(stderr, "   -q:  keep the graph loaded and solve each query "
+         "in queries\n");
+   fprintf(stderr, "   -2:  split the matrix into 2D blocks on a grid of "
+         "processes\n");
+   fprintf(stderr, "   -W:  keep each node's block columns in one shared "
+         "window\n");
+   fprintf(stderr, "   -H:  reduce the minimum inside each node, then "
+         "across nodes\n");
+   fprintf(stderr, "   -F:  mark settled vertices in the distances and "
+         "relax and find the minimum\n        in one pass\n");
+   fprintf(stderr, "   -G:  solve on the GPU\n");
+   fprintf(stderr, "   -z:  pack the edges sent when reading text and "
+         "written by -s -c\n");
+   fprintf(stderr, "   -R:  only find the vertices within distance "
+         "radius of src\n");
+   fprintf(stderr, "   -E:  find paths at most 1 + eps times the "
+         "shortest\n");
+   fprintf(stderr, "   -C:  save the solver's state to checkpoint every "
+         "-I steps (%d)\n", CKPT_STEPS);
+   fprintf(stderr, "   -r:  resume from the last checkpoint saved with -C\n");
+   fprintf(stderr, "   -x:  write the shortest-path tree and its index to "
+         "a binary file\n");
+   fprintf(stderr, "   -c:  convert text on stdin to a binary graph file\n");
+}  /* Usage */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_edges
+ * Purpose:   Read in an edge list on process 0 and send each process
+ *            the edges whose destinations it owns.  Each process then
+ *            builds its CSR block.
+ * In args:   balance:  whether to size the blocks by edge count 
+ *               (note 13)
+ *            pack:  send each process its edges packed in CSR order
+ *               (note 26)
+ *            my_rank:  the caller's rank in comm
+ *            comm:  Communicator consisting of all the processes
+ * In/out:    part:  the vertices owned by each process.  With 
+ *               balance it's replaced by the balanced blocks.
+ * Out arg:   loc_g:  the calling process' block of the graph
+ *
+ * Note:      The input is m, the number of edges, followed by m
+ *            triples u v w.  Edges with w >= NO_EDGE are dropped.
+ */
+void Read_edges(csr_t* loc_g, part_t* part, int balance, int pack, 
+      int my_rank, MPI_Comm comm) {
+   edge_t *edges = NULL, *sorted = NULL, *loc_edges;
+   int *counts = NULL, *displs = NULL, *info = NULL, loc_info[3];
+   int m = 0, loc_m, i, e, q, u, v;
+   pack_t pk = {0, 0, NULL};
+   unsigned char* bytes;
+   weight_t w;
+   int64_t* cols_ptr;
+   int p = part->p, n = part->first[part->p];
+   MPI_Datatype edge_mpi_t;
+   double t0;
 
-   MPI_Gather(loc_pred, loc_n, MPI_INT, pred, loc_n, MPI_INT, 0, comm);
+   edge_mpi_t = Build_edge_type();
 
+   TIC(t0);
    if (my_rank == 0) {
-      path =  malloc(n*sizeof(int));
+      counts = calloc(p, sizeof(int));
+      displs = malloc(p*sizeof(int));
+      scanf("%d", &m);
+      edges = malloc(m*sizeof(edge_t));
+      e = 0;
+      for (i = 0; i < m; i++) {
+         if (scanf("%d %d %" WEIGHT_SCN, &u, &v, &w) != 3) break;
+         if (u < 0 || u >= n || v < 0 || v >= n || w >= NO_EDGE)
+            continue;
+         edges[e].u = u;
+         edges[e].v = v;
+         edges[e].w = w;
+         e++;
+      }
+      m = e;
 
-      printf("The shortest path from 0 to each vertex is:\n");
-      printf("  v     Path 0->v\n");
-      printf("----    ---------\n");
-      for (v = 1; v < n; v++) {
-         printf("%3d:    ", v);
-         count = 0;
-         w = v;
-         while (w != 0) {
-            path[count] = w;
-            count++;
-            w = pred[w];
-         }
-         printf("0 ");
-         for (i = count-1; i >= 0; i--)
-            printf("%d ", path[i]);
-         printf("\n");
+      if (balance) {
+         cols_ptr = calloc(n + 1, sizeof(int64_t));
+         for (e = 0; e < m; e++)
+            cols_ptr[edges[e].v + 1]++;
+         for (v = 0; v < n; v++)
+            cols_ptr[v+1] += cols_ptr[v];
+         Balance_part(part, cols_ptr);
+         free(cols_ptr);
       }
+      for (e = 0; e < m; e++)
+         counts[Owner(part, edges[e].v)]++;
+      sorted = malloc(m*sizeof(edge_t));
+      if (pack) Sort_edges(edges, sorted, m, n);
 
-      free(path);
-      free(pred);
+      /* Bucket the edges by the process that owns the destination. */
+      /* The buckets keep the order of edges.                       */
+      displs[0] = 0;
+      for (q = 1; q < p; q++)
+         displs[q] = displs[q-1] + counts[q-1];
+      for (e = 0; e < m; e++) {
+         q = Owner(part, edges[e].v);
+         sorted[displs[q]] = edges[e];
+         displs[q]++;
+      }
+      for (q = 0; q < p; q++)
+         displs[q] -= counts[q];
+      free(edges);
+
+      /* info[3*q] .. info[3*q+2] are q's edges, rows and bytes */
+      if (pack) {
+         info = malloc(3*p*sizeof(int));
+         for (q = 0; q < p; q++) {
+            loc_edges = sorted + displs[q];
+            for (e = 0; e < counts[q]; e++)
+               loc_edges[e].v -= part->first[q];
+            info[3*q] = counts[q];
+            displs[q] = pk.size;
+            info[3*q + 1] = Pack_rows(&pk, loc_edges, counts[q]);
+            counts[q] = info[3*q + 2] = pk.size - displs[q];
+         }
+      }
+   }
+   TOC(t0, T_PARSE);
+
+   TIC(t0);
+   if (balance) {
+      MPI_Bcast(part->first, p + 1, MPI_INT, 0, comm);
+      COUNT_COLL((p + 1)*sizeof(int));
+      for (q = 0; q < p; q++)
+         part->counts[q] = part->first[q+1] - part->first[q];
+   }
+   if (pack) {
+      MPI_Scatter(info, 3, MPI_INT, loc_info, 3, MPI_INT, 0, comm);
+      bytes = malloc(loc_info[2]);
+      MPI_Scatterv(pk.bytes, counts, displs, MPI_BYTE, bytes, 
+            loc_info[2], MPI_BYTE, 0, comm);
+      COUNT_COLL(3*sizeof(int));
+      COUNT_COLL(loc_info[2]);
+      TOC(t0, T_SCATTER);
+
+      Unpack_rows(loc_g, bytes, loc_info[0], loc_info[1]);
+      free(bytes);
+   } else {
+      MPI_Scatter(counts, 1, MPI_INT, &loc_m, 1, MPI_INT, 0, comm);
+      loc_edges = malloc(loc_m*sizeof(edge_t));
+      MPI_Scatterv(sorted, counts, displs, edge_mpi_t,
+            loc_edges, loc_m, edge_mpi_t, 0, comm);
+      COUNT_COLL(sizeof(int));
+      COUNT_COLL((long long) loc_m*sizeof(edge_t));
+      TOC(t0, T_SCATTER);
+
+      /* Convert destinations to local indices */
+      for (e = 0; e < loc_m; e++)
+         loc_edges[e].v -= part->first[my_rank];
+      Build_csr(loc_g, loc_edges, loc_m);
+      free(loc_edges);
+   }
+
+   if (my_rank == 0) {
+      free(sorted);
+      free(counts);
+      free(displs);
+      free(info);
+      free(pk.bytes);
    }
-}  /* Print_paths */
\ No newline at end of file
+   MPI_Type_free(&edge_mpi_t);
+}  /* Read_edges */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Sort_edges
+ * Purpose:   Sort edges by source and then by destination with two
+ *            counting sorts, so it takes O(n + m) time
+ * In args:   m:  the number of edges
+ *            n:  the number of vertices
+ * In/out:    edges:  the edges
+ * Scratch:   tmp:  storage for m edges
+ */
+void Sort_edges(edge_t edges[], edge_t tmp[], int m, int n) {
+   int* first = malloc((n + 1)*sizeof(int));
+   int e, v;
+
+   memset(first, 0, (n + 1)*sizeof(int));
+   for (e = 0; e < m; e++)
+      first[edges[e].v + 1]++;
+   for (v = 0; v < n; v++)
+      first[v+1] += first[v];
+   for (e = 0; e < m; e++)
+      tmp[first[edges[e].v]++] = edges[e];
+
+   memset(first, 0, (n + 1)*sizeof(int));
+   for (e = 0; e < m; e++)
+      first[tmp[e].u + 1]++;
+   for (v = 0; v < n; v++)
+      first[v+1] += first[v];
+   for (e = 0; e < m; e++)
+      edges[first[tmp[e].u]++] = tmp[e];
+
+   free(first);
+}  /* Sort_edges */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Compare_edges
+ * Purpose:   qsort comparison function that orders edges by source
+ *            and then by destination
+ */
+static int Compare_edges(const void* a, const void* b) {
+   const edge_t* e = a;
+   const edge_t* f = b;
+
+   if (e->u != f->u) return (e->u < f->u) ? -1 : 1;
+   if (e->v != f->v) return (e->v < f->v) ? -1 : 1;
+   return 0;
+}  /* Compare_edges */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Build_csr
+ * Purpose:   Build a process' CSR block from its list of edges
+ * In args:   loc_m:  the number of edges
+ * In/out:    edges:  loc_m edges u->v, with v a local index.  On
+ *               return they are sorted by u.
+ * Out arg:   loc_g:  the CSR block
+ */
+void Build_csr(csr_t* loc_g, edge_t edges[], int loc_m) {
+   int e, r;
+
+   qsort(edges, loc_m, sizeof(edge_t), Compare_edges);
+
+   loc_g->loc_m = loc_m;
+   loc_g->loc_rows = 0;
+   for (e = 0; e < loc_m; e++)
+      if (e == 0 || edges[e].u != edges[e-1].u)
+         loc_g->loc_rows++;
+
+   loc_g->rows = malloc(loc_g->loc_rows*sizeof(int));
+   loc_g->row_ptr = malloc((loc_g->loc_rows + 1)*sizeof(int));
+   loc_g->cols = malloc(loc_m*sizeof(int));
+   loc_g->wts = malloc(loc_m*sizeof(weight_t));
+
+   r = -1;
+   for (e = 0; e < loc_m; e++) {
+      if (e == 0 || edges[e].u != edges[e-1].u) {
+         r++;
+         loc_g->rows[r] = edges[e].u;
+         loc_g->row_ptr[r] = e;
+      }
+      loc_g->cols[e] = edges[e].v;
+      loc_g->wts[e] = edges[e].w;
+   }
+   loc_g->row_ptr[loc_g->loc_rows] = loc_m;
+}  /* Build_csr */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Pack_rows
+ * Purpose:   Append a process' edges to a packed buffer in the order
+ *            of its CSR block (note 26)
+ * In args:   edges:  loc_m edges sorted by source and then by 
+ *               destination.  The destinations are local.
+ *            loc_m:  the number of edges
+ * In/out:    pk:  the packed buffer
+ * Ret val:   The number of rows, i.e., of distinct sources
+ */
+int Pack_rows(pack_t* pk, edge_t edges[], int loc_m) {
+   int e, f, u = 0, v, rows = 0;
+
+   for (e = 0; e < loc_m; e = f) {
+      for (f = e + 1; f < loc_m && edges[f].u == edges[e].u; f++)
+         ;
+      Put_varint(pk, edges[e].u - u);
+      Put_varint(pk, f - e);
+      u = edges[e].u;
+      for (v = 0; e < f; e++) {
+         Put_varint(pk, edges[e].v - v);
+         Put_weight(pk, edges[e].w);
+         v = edges[e].v;
+      }
+      rows++;
+   }
+   return rows;
+}  /* Pack_rows */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Unpack_rows
+ * Purpose:   Build a process' CSR block from the edges packed by 
+ *            Pack_rows
+ * In args:   bytes:  the packed edges
+ *            loc_m:  the number of edges
+ *            loc_rows:  the number of rows
+ * Out arg:   loc_g:  the CSR block, as Build_csr would build it
+ */
+void Unpack_rows(csr_t* loc_g, const unsigned char bytes[], int loc_m, 
+      int loc_rows) {
+   const unsigned char* p = bytes;
+   int r, e = 0, end, u = 0, v;
+
+   loc_g->loc_m = loc_m;
+   loc_g->loc_rows = loc_rows;
+   loc_g->rows = malloc(loc_rows*sizeof(int));
+   loc_g->row_ptr = malloc((loc_rows + 1)*sizeof(int));
+   loc_g->cols = malloc(loc_m*sizeof(int));
+   loc_g->wts = malloc(loc_m*sizeof(weight_t));
+
+   for (r = 0; r < loc_rows; r++) {
+      u += Get_varint(&p);
+      loc_g->rows[r] = u;
+      loc_g->row_ptr[r] = e;
+      end = e + Get_varint(&p);
+      for (v = 0; e < end; e++) {
+         v += Get_varint(&p);
+         loc_g->cols[e] = v;
+         loc_g->wts[e] = Get_weight(&p);
+      }
+   }
+   loc_g->row_ptr[loc_rows] = loc_m;
+}  /* Unpack_rows */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Free_csr
+ * Purpose:   Free the storage allocated by Build_csr
+ * In/out:    loc_g:  the CSR block
+ */
+void Free_csr(csr_t* loc_g) {
+   free(loc_g->rows);
+   free(loc_g->row_ptr);
+   free(loc_g->cols);
+   free(loc_g->wts);
+}  /* Free_csr */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Find_row
+ * Purpose:   Binary search for the row holding the edges out of u
+ * In args:   loc_g:  the CSR block
+ *            u:  a global vertex
+ * Ret val:   The index r with loc_g->rows[r] == u, or -1 if none of
+ *            u's edges end in this block.
+ */
+int Find_row(csr_t* loc_g, int u) {
+   int lo = 0, hi = loc_g->loc_rows - 1, mid;
+
+   while (lo <= hi) {
+      mid = lo + (hi - lo)/2;
+      if (loc_g->rows[mid] == u)
+         return mid;
+      else if (loc_g->rows[mid] < u)
+         lo = mid + 1;
+      else
+         hi = mid - 1;
+   }
+   return -1;
+}  /* Find_row */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Relax_sparse
+ * Purpose:   Relax the edges out of the newly settled vertex u that
+ *            end in the calling process' block
+ * In args:   loc_g:  the CSR block
+ *            u:  the global vertex that was just settled
+ *            u_dist:  the length of the shortest path src->u
+ *            known, gen:  the shortest path src->v is known if 
+ *               known[v] == gen (note 23)
+ * In/out:    loc_dist, loc_pred:  local distances and predecessors
+ *            heap:  the local frontier, or NULL if there isn't one.
+ *               Vertices whose distances drop are added or moved up.
+ */
+void Relax_sparse(csr_t* loc_g, int u, dist_t u_dist, dist_t loc_dist[],
+      int loc_pred[], int known[], int gen, heap_t* heap) {
+   int r, e, v;
+   dist_t new_dist;
+
+   r = Find_row(loc_g, u);
+   if (r < 0) return;
+
+   for (e = loc_g->row_ptr[r]; e < loc_g->row_ptr[r+1]; e++) {
+      v = loc_g->cols[e];
+      if (known[v] != gen) {
+         new_dist = DIST_ADD(u_dist, loc_g->wts[e]);
+         if (new_dist < loc_dist[v]) {
+            loc_dist[v] = new_dist;
+            loc_pred[v] = u;
+            if (heap != NULL) Heap_update(heap, v);
+         }
+      }
+   }
+}  /* Relax_sparse */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_sparse
+ * Purpose:     Apply Dijkstra's algorithm to a graph stored as CSR
+ *              blocks.  This is the same algorithm as Dijkstra, but
+ *              after the global minimum u is found only the edges
+ *              out of u are examined, and the local minimum comes 
+ *              from a heap (note 9).
+ * In args:     loc_g:  the calling process' CSR block
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              radius:  stop once the global minimum is greater, or
+ *                 INFINITY (note 27)
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances
+ *              loc_pred:  subarray of predecessors
+ */
+void Dijkstra_sparse(csr_t* loc_g, dist_t loc_dist[], int loc_pred[], 
+      int loc_n, int my_first, int n, int src, dist_t radius, 
+      int targets[], int n_targets, MPI_Comm comm) {
+   int i, loc_u, u, v, *known = work.stamp, gen = Next_gen();
+   dist_t min_dist;
+   pair_t my_min, glbl_min;
+   int remaining = (targets != NULL) ? n_targets : n;
+   heap_t* heap = &work.heap;
+   double t0;
+
+   /* Nothing is stamped with gen yet.  See note 23. */
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = INFINITY;
+      loc_pred[v] = src;
+   }
+   Heap_clear(heap, loc_dist);
+
+   if (OWNS(my_first, loc_n, src)) {
+      loc_dist[src - my_first] = 0;
+      known[src - my_first] = gen;
+      stats.settled++;
+   }
+   if (Is_target(src, targets, n_targets)) remaining--;
+   Relax_sparse(loc_g, src, 0, loc_dist, loc_pred, known, gen, heap);
+
+   for (i = 1; i < n && remaining > 0; i++) {
+      TIC(t0);
+      loc_u = (heap->size > 0) ? heap->verts[0] : NO_VERTEX;
+
+      if (loc_u < NO_VERTEX) {
+         my_min.dist = loc_dist[loc_u];
+         my_min.v = loc_u + my_first;
+      } else {
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
+      }
+
+      TOC(t0, T_MIN);
+
+      TIC(t0);
+      Allreduce_minloc(&my_min, &glbl_min, 1, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+      min_dist = glbl_min.dist;
+      u = glbl_min.v;
+
+      if (min_dist >= INFINITY || min_dist > radius) break;
+
+      /* Ties go to the smaller vertex, so u is the top of its heap */
+      TIC(t0);
+      if (OWNS(my_first, loc_n, u)) {
+         known[Heap_pop(heap)] = gen;
+         stats.settled++;
+      }
+      TOC(t0, T_MIN);
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+
+      TIC(t0);
+      Relax_sparse(loc_g, u, min_dist, loc_dist, loc_pred, known, gen, 
+            heap);
+      TOC(t0, T_RELAX);
+   } /* for i */
+}  /* Dijkstra_sparse */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Check_for_error
+ * Purpose:   Check whether any process has found an error.  If so,
+ *            print message and terminate all processes.  Otherwise,
+ *            continue execution.
+ * In args:   local_ok:  0 if calling process has found an error, 1
+ *               otherwise
+ *            message:  message to print if there's an error
+ *            comm:  communicator containing processes calling
+ *               Check_for_error:  should be MPI_COMM_WORLD.
+ */
+void Check_for_error(int local_ok, char message[], MPI_Comm comm) {
+   int ok, my_rank;
+
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   if (ok == 0) {
+      MPI_Comm_rank(comm, &my_rank);
+      if (my_rank == 0) {
+         fprintf(stderr, "%s\n", message);
+         fflush(stderr);
+      }
+      MPI_Finalize();
+      exit(-1);
+   }
+}  /* Check_for_error */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Map_graph
+ * Purpose:   Map a binary graph file into the calling process' 
+ *            address space and check its header
+ * In args:   fname:  the name of the file
+ *            comm:  Communicator consisting of all the processes
+ * Out args:  hdr:  a copy of the file's header
+ *            size_p:  the number of bytes mapped
+ * Ret val:   The start of the mapping.  The payload starts 
+ *            sizeof(graph_hdr_t) bytes in.
+ */
+void* Map_graph(char fname[], graph_hdr_t* hdr, size_t* size_p, 
+      MPI_Comm comm) {
+   int fd, local_ok = 1;
+   struct stat st;
+   void* map = MAP_FAILED;
+
+   fd = open(fname, O_RDONLY);
+   if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < sizeof(graph_hdr_t))
+      local_ok = 0;
+   Check_for_error(local_ok, "Can't open graph file", comm);
+
+   map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED) local_ok = 0;
+   Check_for_error(local_ok, "Can't map graph file", comm);
+
+   memcpy(hdr, map, sizeof(graph_hdr_t));
+   *size_p = st.st_size;
+   Check_for_error(memcmp(hdr->magic, GRAPH_MAGIC, 4) != 0 
+         || hdr->weight_type == WEIGHT_CODE,
+         "The graph file's weight type needs another build (note 15)", comm);
+   local_ok = Check_hdr(hdr, *size_p);
+   if (local_ok && hdr->layout == LAYOUT_CSC_PACKED)
+      local_ok = (Packed_size(hdr, ((int64_t*) ((char*) map 
+                  + sizeof(graph_hdr_t)))[2*hdr->n + 1]) == *size_p);
+   Check_for_error(local_ok, "Bad graph file header", comm);
+
+   return map;
+}  /* Map_graph */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Load_dense
+ * Purpose:   Copy the calling process' block column out of a mapped
+ *            LAYOUT_DENSE graph file
+ * In args:   map:  the mapping returned by Map_graph
+ *            n:  the number of rows in the matrix
+ *            loc_n:  the number of columns in the block column
+ *            my_first:  the first column of the block column
+ * Out arg:   loc_mat:  the calling process' submatrix
+ */
+void Load_dense(void* map, weight_t loc_mat[], int n, int loc_n, 
+      int my_first) {
+   const weight_t* mat = (const weight_t*) ((char*) map 
+         + sizeof(graph_hdr_t));
+   size_t i;
+
+   for (i = 0; i < n; i++)
+      memcpy(&loc_mat[i*loc_n], &mat[i*n + my_first],
+            loc_n*sizeof(weight_t));
+}  /* Load_dense */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Load_csr
+ * Purpose:   Build the calling process' CSR block from the edges into
+ *            its vertices in a mapped LAYOUT_CSC or LAYOUT_CSC_PACKED
+ *            graph file
+ * In args:   map:  the mapping returned by Map_graph
+ *            hdr:  the file's header
+ *            loc_n:  the number of vertices owned by the process
+ *            my_first:  the first vertex owned by the process
+ * Out arg:   loc_g:  the calling process' block of the graph
+ *
+ * Note:      The weights follow m int32 sources, so they needn't be
+ *            aligned for weight_t and are copied a byte at a time.
+ *            Packed columns are decoded by Unpack_cols.
+ */
+void Load_csr(void* map, graph_hdr_t* hdr, csr_t* loc_g, int loc_n, 
+      int my_first) {
+   const int64_t* cols_ptr = (const int64_t*) ((char*) map 
+         + sizeof(graph_hdr_t));
+   const int32_t* srcs = (const int32_t*) (cols_ptr + hdr->n + 1);
+   const char* wts = (const char*) (srcs + hdr->m);
+   const int64_t* bytes_ptr = cols_ptr + hdr->n + 1;
+   const unsigned char* bytes = (const unsigned char*) 
+      (bytes_ptr + hdr->n + 1);
+   int64_t e, first = cols_ptr[my_first];
+   int v, loc_m = 0;
+   edge_t* edges;
+
+   edges = malloc((cols_ptr[my_first + loc_n] - first)*sizeof(edge_t));
+   if (hdr->layout == LAYOUT_CSC_PACKED) {
+      loc_m = cols_ptr[my_first + loc_n] - first;
+      Unpack_cols(bytes + bytes_ptr[my_first], cols_ptr + my_first, loc_n,
+            edges);
+   } else {
+      for (v = 0; v < loc_n; v++)
+         for (e = cols_ptr[my_first + v]; 
+               e < cols_ptr[my_first + v + 1]; e++) {
+            edges[loc_m].u = srcs[e];
+            edges[loc_m].v = v;
+            memcpy(&edges[loc_m].w, wts + e*sizeof(weight_t), 
+                  sizeof(weight_t));
+            loc_m++;
+         }
+   }
+
+   Build_csr(loc_g, edges, loc_m);
+   free(edges);
+}  /* Load_csr */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Pack_col
+ * Purpose:   Append the edges into one vertex to a packed buffer as a
+ *            column of a LAYOUT_CSC_PACKED file (note 26)
+ * In args:   srcs:  the sources of the edges in increasing order
+ *            wts:  the weights of the edges
+ *            deg:  the number of edges
+ * In/out:    pk:  the packed buffer
+ */
+void Pack_col(pack_t* pk, int32_t srcs[], weight_t wts[], int64_t deg) {
+   int64_t e;
+   int32_t u = 0;
+
+   for (e = 0; e < deg; e++) {
+      Put_varint(pk, srcs[e] - u);
+      Put_weight(pk, wts[e]);
+      u = srcs[e];
+   }
+}  /* Pack_col */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Unpack_cols
+ * Purpose:   Decode consecutive columns written by Pack_col into an 
+ *            edge list
+ * In args:   bytes:  the first column
+ *            cols_ptr:  the loc_n+1 entries of cols_ptr for the 
+ *               columns, so column v has cols_ptr[v+1]-cols_ptr[v]
+ *               edges
+ *            loc_n:  the number of columns
+ * Out arg:   edges:  the edges, with destination v for column v
+ */
+void Unpack_cols(const unsigned char bytes[], const int64_t cols_ptr[],
+      int loc_n, edge_t edges[]) {
+   const unsigned char* p = bytes;
+   int64_t e, k = 0;
+   int u, v;
+
+   for (v = 0; v < loc_n; v++)
+      for (u = 0, e = cols_ptr[v]; e < cols_ptr[v+1]; e++, k++) {
+         u += Get_varint(&p);
+         edges[k].u = u;
+         edges[k].v = v;
+         edges[k].w = Get_weight(&p);
+      }
+}  /* Unpack_cols */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Convert_text
+ * Purpose:   Read a graph in the text format from stdin and write it
+ *            to a binary graph file.  Only called by one process.
+ * In args:   fname:  the binary file to write
+ *            sparse:  1 if the input is an edge list, 0 if it's a
+ *               matrix
+ *            pack:  write an edge list as LAYOUT_CSC_PACKED
+ *
+ * Note:      Edge lists are written as LAYOUT_CSC, or with pack as
+ *            LAYOUT_CSC_PACKED, and matrices as LAYOUT_DENSE.  
+ *            Matrices are copied a row at a time, so the whole matrix
+ *            is never stored.
+ */
+void Convert_text(char fname[], int sparse, int pack) {
+   FILE* fp;
+   graph_hdr_t hdr;
+   weight_t *row, *wts, w;
+   int32_t* srcs;
+   edge_t *edges, *tmp;
+   int64_t *cols_ptr, *bytes_ptr, i, j, e, m = 0;
+   int n, u, v;
+   pack_t pk = {0, 0, NULL};
+
+   fp = fopen(fname, "wb");
+   if (fp == NULL || scanf("%d", &n) != 1 || n <= 0) {
+      fprintf(stderr, "Can't convert to %s\n", fname);
+      if (fp != NULL) fclose(fp);
+      return;
+   }
+
+   memcpy(hdr.magic, GRAPH_MAGIC, 4);
+   hdr.version = GRAPH_VERSION;
+   hdr.weight_type = WEIGHT_CODE;
+   hdr.n = n;
+   hdr.m = 0;
+
+   if (!sparse) {
+      hdr.layout = LAYOUT_DENSE;
+      fwrite(&hdr, sizeof(hdr), 1, fp);
+      row = malloc(n*sizeof(weight_t));
+      for (i = 0; i < n; i++) {
+         for (j = 0; j < n; j++)
+            scanf("%" WEIGHT_SCN, &row[j]);
+         fwrite(row, sizeof(weight_t), n, fp);
+      }
+      free(row);
+   } else {
+      /* Read the edges and counting sort them by destination */
+      hdr.layout = pack ? LAYOUT_CSC_PACKED : LAYOUT_CSC;
+      scanf("%" SCNd64, &m);
+      edges = malloc(m*sizeof(edge_t));
+      cols_ptr = calloc(n + 1, sizeof(int64_t));
+      e = 0;
+      for (i = 0; i < m; i++) {
+         if (scanf("%d %d %" WEIGHT_SCN, &u, &v, &w) != 3) break;
+         if (u < 0 || u >= n || v < 0 || v >= n || w >= NO_EDGE)
+            continue;
+         edges[e].u = u;
+         edges[e].v = v;
+         edges[e].w = w;
+         cols_ptr[v+1]++;
+         e++;
+      }
+      hdr.m = m = e;
+      for (v = 0; v < n; v++)
+         cols_ptr[v+1] += cols_ptr[v];
+
+      /* The counting sort below is stable, so sorting by source */
+      /* first leaves each column sorted                          */
+      if (pack) {
+         tmp = malloc(m*sizeof(edge_t));
+         Sort_edges(edges, tmp, m, n);
+         free(tmp);
+      }
+
+      srcs = malloc(m*sizeof(int32_t));
+      wts = malloc(m*sizeof(weight_t));
+      for (e = 0; e < m; e++) {
+         v = edges[e].v;
+         srcs[cols_ptr[v]] = edges[e].u;
+         wts[cols_ptr[v]] = edges[e].w;
+         cols_ptr[v]++;
+      }
+      for (v = n; v > 0; v--)
+         cols_ptr[v] = cols_ptr[v-1];
+      cols_ptr[0] = 0;
+
+      fwrite(&hdr, sizeof(hdr), 1, fp);
+      fwrite(cols_ptr, sizeof(int64_t), n + 1, fp);
+      if (pack) {
+         bytes_ptr = malloc((n + 1)*sizeof(int64_t));
+         for (v = 0; v < n; v++) {
+            bytes_ptr[v] = pk.size;
+            Pack_col(&pk, srcs + cols_ptr[v], wts + cols_ptr[v], 
+                  cols_ptr[v+1] - cols_ptr[v]);
+         }
+         bytes_ptr[n] = pk.size;
+         fwrite(bytes_ptr, sizeof(int64_t), n + 1, fp);
+         fwrite(pk.bytes, 1, pk.size, fp);
+         free(bytes_ptr);
+         free(pk.bytes);
+      } else {
+         fwrite(srcs, sizeof(int32_t), m, fp);
+         fwrite(wts, sizeof(weight_t), m, fp);
+      }
+      free(edges);
+      free(cols_ptr);
+      free(srcs);
+      free(wts);
+   }
+
+   fclose(fp);
+}  /* Convert_text */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Check_hdr
+ * Purpose:   Check that a graph file header is one we can load and
+ *            that it agrees with the size of the file
+ * In args:   hdr:  the header
+ *            size:  the size of the file in bytes
+ * Ret val:   1 if the header is OK, 0 otherwise
+ */
+int Check_hdr(graph_hdr_t* hdr, size_t size) {
+   size_t expected;
+
+   if (memcmp(hdr->magic, GRAPH_MAGIC, 4) != 0 
+         || hdr->version != GRAPH_VERSION
+         || hdr->weight_type != WEIGHT_CODE || hdr->n <= 0)
+      return 0;
+   else if (hdr->layout == LAYOUT_DENSE)
+      expected = sizeof(graph_hdr_t) + hdr->n*hdr->n*sizeof(weight_t);
+   else if (hdr->layout == LAYOUT_CSC)
+      expected = sizeof(graph_hdr_t) + (hdr->n + 1)*sizeof(int64_t)
+         + hdr->m*(sizeof(int32_t) + sizeof(weight_t));
+   else if (hdr->layout == LAYOUT_CSC_PACKED)
+      /* The packed columns are checked against bytes_ptr[n] later */
+      return size >= sizeof(graph_hdr_t) + 2*(hdr->n + 1)*sizeof(int64_t);
+   else
+      return 0;
+
+   return expected == size;
+}  /* Check_hdr */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Packed_size
+ * Purpose:   Find the size a LAYOUT_CSC_PACKED file should have
+ * In args:   hdr:  the file's header
+ *            end:  bytes_ptr[n], the number of bytes of packed columns
+ * Ret val:   The size in bytes
+ */
+size_t Packed_size(graph_hdr_t* hdr, int64_t end) {
+   return sizeof(graph_hdr_t) + 2*(hdr->n + 1)*sizeof(int64_t) + end;
+}  /* Packed_size */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Open_graph
+ * Purpose:   Collectively open a binary graph file for MPI-IO and 
+ *            read its header
+ * In args:   fname:  the name of the file
+ *            comm:  Communicator consisting of all the processes
+ * Out args:  hdr:  the file's header
+ *            fh_p:  the open file
+ */
+void Open_graph(char fname[], graph_hdr_t* hdr, MPI_File* fh_p,
+      MPI_Comm comm) {
+   int local_ok = 1;
+   MPI_Offset size = 0;
+   int64_t end;
+
+   if (MPI_File_open(comm, fname, MPI_MODE_RDONLY, MPI_INFO_NULL, fh_p)
+         != MPI_SUCCESS) {
+      local_ok = 0;
+      *fh_p = MPI_FILE_NULL;
+   }
+   Check_for_error(local_ok, "Can't open graph file", comm);
+
+   MPI_File_get_size(*fh_p, &size);
+   if (size >= sizeof(graph_hdr_t)) {
+      MPI_File_read_at_all(*fh_p, 0, hdr, sizeof(graph_hdr_t), MPI_BYTE,
+            MPI_STATUS_IGNORE);
+      Check_for_error(memcmp(hdr->magic, GRAPH_MAGIC, 4) != 0 
+            || hdr->weight_type == WEIGHT_CODE,
+            "The graph file's weight type needs another build (note 15)",
+            comm);
+      local_ok = Check_hdr(hdr, size);
+      if (local_ok && hdr->layout == LAYOUT_CSC_PACKED) {
+         MPI_File_read_at_all(*fh_p, sizeof(graph_hdr_t) 
+               + (2*hdr->n + 1)*sizeof(int64_t), &end, 1, MPI_INT64_T,
+               MPI_STATUS_IGNORE);
+         local_ok = (Packed_size(hdr, end) == size);
+      }
+   } else {
+      local_ok = 0;
+   }
+   Check_for_error(local_ok, "Bad graph file header", comm);
+}  /* Open_graph */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_dense_all
+ * Purpose:   Read each process' block column of a LAYOUT_DENSE graph
+ *            file directly into loc_mat with one collective read
+ * In args:   fh:  the file opened by Open_graph
+ *            n:  the number of rows in the matrix
+ *            loc_n:  the number of columns in the block column
+ *            my_first:  the first column of the block column
+ * Out arg:   loc_mat:  the calling process' submatrix
+ *
+ * Note:      The filetype picks the first loc_n entries out of each
+ *            row of the matrix, so with the view starting at the
+ *            process' first column it's exactly the process' block
+ *            column.  Its width differs between processes, so each
+ *            process builds its own.
+ */
+void Read_dense_all(MPI_File fh, weight_t loc_mat[], int n, int loc_n,
+      int my_first) {
+   MPI_Offset disp = sizeof(graph_hdr_t) 
+      + (MPI_Offset) my_first*sizeof(weight_t);
+   MPI_Datatype file_mpi_t;
+
+   MPI_Type_vector(n, loc_n, n, WEIGHT_MPI, &file_mpi_t);
+   MPI_Type_commit(&file_mpi_t);
+   MPI_File_set_view(fh, disp, WEIGHT_MPI, file_mpi_t, "native", 
+         MPI_INFO_NULL);
+   MPI_File_read_all(fh, loc_mat, n*loc_n, WEIGHT_MPI, MPI_STATUS_IGNORE);
+   MPI_Type_free(&file_mpi_t);
+}  /* Read_dense_all */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_csr_all
+ * Purpose:   Read the edges into each process' vertices from a
+ *            LAYOUT_CSC or LAYOUT_CSC_PACKED graph file with 
+ *            collective reads and build the process' CSR block
+ * In args:   fh:  the file opened by Open_graph
+ *            hdr:  the file's header
+ *            loc_n:  the number of vertices owned by the process
+ *            my_first:  the first vertex owned by the process
+ * Out arg:   loc_g:  the calling process' block of the graph
+ */
+void Read_csr_all(MPI_File fh, graph_hdr_t* hdr, csr_t* loc_g, int loc_n,
+      int my_first) {
+   MPI_Offset ptr_start = sizeof(graph_hdr_t);
+   MPI_Offset srcs_start = ptr_start + (hdr->n + 1)*sizeof(int64_t);
+   MPI_Offset wts_start = srcs_start + hdr->m*sizeof(int32_t);
+   int64_t* cols_ptr = malloc((loc_n + 1)*sizeof(int64_t));
+   int64_t bytes_ptr[2];
+   int32_t* srcs;
+   weight_t* wts;
+   edge_t* edges;
+   unsigned char* bytes;
+   int64_t e;
+   int v, loc_m;
+
+   MPI_File_read_at_all(fh, 
+         ptr_start + (MPI_Offset) my_first*sizeof(int64_t),
+         cols_ptr, loc_n + 1, MPI_INT64_T, MPI_STATUS_IGNORE);
+   loc_m = cols_ptr[loc_n] - cols_ptr[0];
+
+   edges = malloc(loc_m*sizeof(edge_t));
+   if (hdr->layout == LAYOUT_CSC_PACKED) {
+      /* bytes_ptr is where LAYOUT_CSC has its sources.  Only its */
+      /* first and last entries for the block are needed.         */
+      MPI_File_read_at_all(fh, srcs_start 
+            + (MPI_Offset) my_first*sizeof(int64_t), &bytes_ptr[0], 1, 
+            MPI_INT64_T, MPI_STATUS_IGNORE);
+      MPI_File_read_at_all(fh, srcs_start 
+            + (MPI_Offset) (my_first + loc_n)*sizeof(int64_t), 
+            &bytes_ptr[1], 1, MPI_INT64_T, MPI_STATUS_IGNORE);
+      bytes = malloc(bytes_ptr[1] - bytes_ptr[0]);
+      MPI_File_read_at_all(fh, srcs_start + (hdr->n + 1)*sizeof(int64_t)
+            + bytes_ptr[0], bytes, bytes_ptr[1] - bytes_ptr[0], MPI_BYTE,
+            MPI_STATUS_IGNORE);
+      Unpack_cols(bytes, cols_ptr, loc_n, edges);
+      free(bytes);
+   } else {
+      srcs = malloc(loc_m*sizeof(int32_t));
+      wts = malloc(loc_m*sizeof(weight_t));
+      MPI_File_read_at_all(fh, srcs_start + cols_ptr[0]*sizeof(int32_t),
+            srcs, loc_m, MPI_INT32_T, MPI_STATUS_IGNORE);
+      MPI_File_read_at_all(fh, wts_start + cols_ptr[0]*sizeof(weight_t),
+            wts, loc_m, WEIGHT_MPI, MPI_STATUS_IGNORE);
+      for (v = 0; v < loc_n; v++)
+         for (e = cols_ptr[v]; e < cols_ptr[v+1]; e++) {
+            edges[e - cols_ptr[0]].u = srcs[e - cols_ptr[0]];
+            edges[e - cols_ptr[0]].v = v;
+            edges[e - cols_ptr[0]].w = wts[e - cols_ptr[0]];
+         }
+      free(srcs);
+      free(wts);
+   }
+   Build_csr(loc_g, edges, loc_m);
+
+   free(edges);
+   free(cols_ptr);
+}  /* Read_csr_all */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_cols_ptr_all
+ * Purpose:   Read all of cols_ptr from a LAYOUT_CSC graph file on
+ *            every process, for Balance_part
+ * In args:   fh:  the file opened by Open_graph
+ *            n:  the number of vertices
+ * Ret val:   The n+1 offsets.  The caller frees them.
+ */
+int64_t* Read_cols_ptr_all(MPI_File fh, int n) {
+   int64_t* cols_ptr = malloc((n + 1)*sizeof(int64_t));
+
+   MPI_File_read_at_all(fh, sizeof(graph_hdr_t), cols_ptr, n + 1, 
+         MPI_INT64_T, MPI_STATUS_IGNORE);
+   return cols_ptr;
+}  /* Read_cols_ptr_all */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Delta_stepping
+ * Purpose:     Find the shortest paths from 0 with delta-stepping.
+ *              See note 5.
+ * In args:     loc_mat:  the calling process' block column, or NULL
+ *                 in sparse mode
+ *              loc_g:  the calling process' CSR block, or NULL in
+ *                 dense mode
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              p:  the number of processes
+ *              delta:  the width of a bucket
+ *              src:  the source vertex
+ *              radius:  stop once the next bucket's smallest 
+ *                 distance is greater, or INFINITY (note 27)
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances
+ *              loc_pred:  subarray of predecessors
+ *
+ * Note:        Bucket b holds the vertices with tentative distances in
+ *              [b*delta, (b+1)*delta).  The vertices of the current
+ *              bucket whose distances changed are gathered on every
+ *              process, which then relaxes the edges into its own
+ *              vertices.  Light edges (w <= delta) are relaxed until
+ *              the bucket stops changing, and heavy edges once from the
+ *              settled bucket.
+ */
+void Delta_stepping(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+      int loc_pred[], int loc_n, int my_first, int p, dist_t delta, int src,
+      dist_t radius, int targets[], int n_targets, MPI_Comm comm) {
+   int *dirty, *settled, *counts, *displs;
+   pair_t *loc_frontier, *frontier = NULL;
+   int v, loc_count, count, loc_targets = 0, loc_settled_targets = 0;
+   long b;
+   dist_t loc_state[2], glbl_state[2], glbl_min;
+   double t0;
+
+   /* dirty[v] = 1 if loc_dist[v] has changed since v was last sent */
+   /* settled[v] = 1 if v's bucket has been finished                */
+   dirty = malloc(loc_n*sizeof(int));
+   settled = malloc(loc_n*sizeof(int));
+   loc_frontier = malloc(loc_n*sizeof(pair_t));
+   counts = malloc(p*sizeof(int));
+   displs = malloc(p*sizeof(int));
+
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = INFINITY;
+      loc_pred[v] = src;
+      dirty[v] = 0;
+      settled[v] = 0;
+      if (Is_target(v + my_first, targets, n_targets)) loc_targets++;
+   }
+   if (OWNS(my_first, loc_n, src)) {
+      loc_dist[src - my_first] = 0;
+      dirty[src - my_first] = 1;
+   }
+
+   glbl_min = 0;
+   while (glbl_min < INFINITY && glbl_min <= radius) {
+      b = glbl_min/delta;
+
+      /* Relax light edges until no distance in bucket b changes */
+      for (;;) {
+         TIC(t0);
+         loc_count = 0;
+         for (v = 0; v < loc_n; v++)
+            if (dirty[v] && (long) (loc_dist[v]/delta) == b) {
+               loc_frontier[loc_count].dist = loc_dist[v];
+               loc_frontier[loc_count].v = v + my_first;
+               loc_count++;
+               dirty[v] = 0;
+            }
+         TOC(t0, T_MIN);
+         TIC(t0);
+         count = Gather_frontier(loc_frontier, loc_count, &frontier, counts,
+               displs, p, comm);
+         TOC(t0, T_COMM);
+         if (count == 0) break;
+         TIC(t0);
+         Relax_frontier(loc_mat, loc_g, frontier, count, 1, delta, loc_dist,
+               loc_pred, dirty, settled, loc_n);
+         TOC(t0, T_RELAX);
+      }
+
+      /* Settle bucket b and relax its heavy edges */
+      TIC(t0);
+      loc_count = 0;
+      for (v = 0; v < loc_n; v++)
+         if (!settled[v] && loc_dist[v] < INFINITY 
+               && (long) (loc_dist[v]/delta) == b) {
+            settled[v] = 1;
+            stats.settled++;
+            if (Is_target(v + my_first, targets, n_targets))
+               loc_settled_targets++;
+            loc_frontier[loc_count].dist = loc_dist[v];
+            loc_frontier[loc_count].v = v + my_first;
+            loc_count++;
+         }
+      TOC(t0, T_MIN);
+      TIC(t0);
+      count = Gather_frontier(loc_frontier, loc_count, &frontier, counts,
+            displs, p, comm);
+      TOC(t0, T_COMM);
+      TIC(t0);
+      Relax_frontier(loc_mat, loc_g, frontier, count, 0, delta, loc_dist,
+            loc_pred, dirty, settled, loc_n);
+      TOC(t0, T_RELAX);
+
+      /* Find the next nonempty bucket, and whether every process */
+      /* has settled all of its targets                           */
+      TIC(t0);
+      loc_state[0] = INFINITY;
+      for (v = 0; v < loc_n; v++)
+         if (!settled[v] && loc_dist[v] < loc_state[0])
+            loc_state[0] = loc_dist[v];
+      loc_state[1] = (loc_settled_targets == loc_targets);
+      TOC(t0, T_MIN);
+      TIC(t0);
+      MPI_Allreduce(loc_state, glbl_state, 2, DIST_MPI, MPI_MIN, comm);
+      COUNT_COLL(sizeof(loc_state));
+      TOC(t0, T_COMM);
+      glbl_min = glbl_state[0];
+      if (n_targets > 0 && glbl_state[1]) break;
+   }
+
+   free(dirty);
+   free(settled);
+   free(loc_frontier);
+   free(frontier);
+   free(counts);
+   free(displs);
+}  /* Delta_stepping */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Gather_frontier
+ * Purpose:     Gather every process' list of (distance, vertex) pairs
+ *              onto every process
+ * In args:     loc_frontier:  the calling process' pairs
+ *              loc_count:  the number of pairs in loc_frontier
+ *              p:  the number of processes
+ *              comm:  MPI Communicator
+ * In/out arg:  frontier_p:  buffer for all the pairs.  It's 
+ *                 reallocated to hold them.
+ * Scratch:     counts, displs:  arrays of p ints
+ * Ret val:     The total number of pairs
+ */
+int Gather_frontier(pair_t loc_frontier[], int loc_count, 
+      pair_t** frontier_p, int counts[], int displs[], int p, 
+      MPI_Comm comm) {
+   int q, count;
+
+   MPI_Allgather(&loc_count, 1, MPI_INT, counts, 1, MPI_INT, comm);
+   COUNT_COLL(sizeof(int));
+   displs[0] = 0;
+   for (q = 1; q < p; q++)
+      displs[q] = displs[q-1] + counts[q-1];
+   count = displs[p-1] + counts[p-1];
+   if (count == 0) return 0;
+
+   *frontier_p = realloc(*frontier_p, count*sizeof(pair_t));
+   MPI_Allgatherv(loc_frontier, loc_count, PAIR_MPI, *frontier_p, counts,
+         displs, PAIR_MPI, comm);
+   COUNT_COLL((long long) count*sizeof(pair_t));
+   return count;
+}  /* Gather_frontier */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_frontier
+ * Purpose:     Relax the edges out of the vertices in frontier that
+ *              end in the calling process' block
+ * In args:     loc_mat:  the block column, or NULL in sparse mode
+ *              loc_g:  the CSR block, or NULL in dense mode
+ *              frontier:  count (distance, vertex) pairs
+ *              light:  1 to relax the edges with weight <= delta, 0
+ *                 to relax the edges with weight > delta
+ *              delta:  the width of a bucket
+ *              settled:  settled[v] = 1 if v's bucket is finished
+ *              loc_n:  the number of vertices in the block
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ *              dirty:  dirty[v] is set when loc_dist[v] decreases
+ */
+void Relax_frontier(weight_t loc_mat[], csr_t* loc_g, pair_t frontier[], 
+      int count, int light, dist_t delta, dist_t loc_dist[], int loc_pred[],
+      int dirty[], int settled[], int loc_n) {
+   int i, u, v, r, e;
+   dist_t u_dist, new_dist;
+   weight_t w;
+
+   for (i = 0; i < count; i++) {
+      u = frontier[i].v;
+      u_dist = frontier[i].dist;
+      if (loc_g != NULL) {
+         r = Find_row(loc_g, u);
+         if (r < 0) continue;
+         for (e = loc_g->row_ptr[r]; e < loc_g->row_ptr[r+1]; e++) {
+            v = loc_g->cols[e];
+            w = loc_g->wts[e];
+            new_dist = DIST_ADD(u_dist, w);
+            if ((w <= delta) == light && !settled[v] 
+                  && new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+               dirty[v] = 1;
+            }
+         }
+      } else {
+#        ifdef _OPENMP
+#        pragma omp parallel for private(w, new_dist) \
+            if (loc_n >= OMP_MIN_N)
+#        endif
+         for (v = 0; v < loc_n; v++) {
+            w = loc_mat[(size_t) u*loc_n + v];
+            new_dist = DIST_ADD(u_dist, w);
+            if (w < NO_EDGE && (w <= delta) == light && !settled[v] 
+                  && new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+               dirty[v] = 1;
+            }
+         }
+      }
+   }
+}  /* Relax_frontier */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_approx
+ * Purpose:     Find paths from src whose lengths are within a factor
+ *              1 + eps of the shortest, settling a band of vertices 
+ *              in each round.  See note 27.
+ * In args:     loc_mat:  the calling process' block column, or NULL
+ *                 in sparse mode
+ *              loc_g:  the calling process' CSR block, or NULL in
+ *                 dense mode
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              p:  the number of processes
+ *              eps:  the tolerance, > 0
+ *              src:  the source vertex
+ *              radius:  stop once the lower bound is greater, or 
+ *                 INFINITY
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances
+ *              loc_pred:  subarray of predecessors
+ *
+ * Note:        Besides loc_dist each vertex has a lower bound lb[v].
+ *              When u is settled in a round whose global lower bound is
+ *              L, v gets dist[v] = min(dist[v], dist[u] + w) and 
+ *              lb[v] = min(lb[v], L + w).  Each round settles every 
+ *              unsettled v with dist[v] <= (1 + eps) L, which always 
+ *              includes the vertex with lb[v] = L, so every settled 
+ *              distance is within 1 + eps of the shortest.
+ */
+void Dijkstra_approx(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+      int loc_pred[], int loc_n, int my_first, int p, double eps, int src, 
+      dist_t radius, int targets[], int n_targets, MPI_Comm comm) {
+   int *settled, *counts, *displs;
+   pair_t *loc_band, *band = NULL;
+   int v, loc_count, count, loc_targets = 0, loc_settled_targets = 0;
+   dist_t *loc_lb, loc_state[2], glbl_state[2], lb_dist, bound;
+   double t0;
+
+   /* loc_lb[v] <= the distance src->v, and settled[v] = 1 once */
+   /* v's distance is final                                     */
+   settled = malloc(loc_n*sizeof(int));
+   loc_lb = malloc(loc_n*sizeof(dist_t));
+   loc_band = malloc(loc_n*sizeof(pair_t));
+   counts = malloc(p*sizeof(int));
+   displs = malloc(p*sizeof(int));
+
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = loc_lb[v] = INFINITY;
+      loc_pred[v] = src;
+      settled[v] = 0;
+      if (Is_target(v + my_first, targets, n_targets)) loc_targets++;
+   }
+   if (OWNS(my_first, loc_n, src))
+      loc_dist[src - my_first] = loc_lb[src - my_first] = 0;
+
+   for (;;) {
+      /* Find the smallest lower bound of an unsettled vertex, and */
+      /* whether every process has settled all of its targets      */
+      TIC(t0);
+      loc_state[0] = INFINITY;
+      for (v = 0; v < loc_n; v++)
+         if (!settled[v] && loc_lb[v] < loc_state[0])
+            loc_state[0] = loc_lb[v];
+      loc_state[1] = (loc_settled_targets == loc_targets);
+      TOC(t0, T_MIN);
+      TIC(t0);
+      MPI_Allreduce(loc_state, glbl_state, 2, DIST_MPI, MPI_MIN, comm);
+      COUNT_COLL(sizeof(loc_state));
+      TOC(t0, T_COMM);
+      lb_dist = glbl_state[0];
+      if (lb_dist >= INFINITY || lb_dist > radius 
+            || (n_targets > 0 && glbl_state[1])) break;
+
+      /* Settle the band.  The vertices with the smallest lower */
+      /* bound are in it anyway, but rounding could lose them.  */
+      TIC(t0);
+      bound = (lb_dist < INFINITY/(1 + eps)) ? (1 + eps)*lb_dist : INFINITY;
+      loc_count = 0;
+      for (v = 0; v < loc_n; v++)
+         if (!settled[v] && loc_dist[v] < INFINITY 
+               && (loc_dist[v] <= bound || loc_lb[v] == lb_dist)) {
+            settled[v] = 1;
+            stats.settled++;
+            if (Is_target(v + my_first, targets, n_targets))
+               loc_settled_targets++;
+            loc_band[loc_count].dist = loc_dist[v];
+            loc_band[loc_count].v = v + my_first;
+            loc_count++;
+         }
+      TOC(t0, T_MIN);
+      TIC(t0);
+      count = Gather_frontier(loc_band, loc_count, &band, counts, displs, 
+            p, comm);
+      TOC(t0, T_COMM);
+      TIC(t0);
+      Relax_band(loc_mat, loc_g, band, count, lb_dist, loc_dist, loc_pred,
+            loc_lb, settled, loc_n);
+      TOC(t0, T_RELAX);
+   }
+
+   free(settled);
+   free(loc_lb);
+   free(loc_band);
+   free(band);
+   free(counts);
+   free(displs);
+}  /* Dijkstra_approx */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_band
+ * Purpose:     Relax the edges out of the vertices in band that end
+ *              in the calling process' block, updating both the 
+ *              distances and their lower bounds
+ * In args:     loc_mat:  the block column, or NULL in sparse mode
+ *              loc_g:  the CSR block, or NULL in dense mode
+ *              band:  count (distance, vertex) pairs
+ *              lb_dist:  the lower bound of the round that settled
+ *                 the band
+ *              settled:  settled[v] = 1 if v's distance is final
+ *              loc_n:  the number of vertices in the block
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ *              loc_lb:  local lower bounds
+ */
+void Relax_band(weight_t loc_mat[], csr_t* loc_g, pair_t band[], 
+      int count, dist_t lb_dist, dist_t loc_dist[], int loc_pred[], 
+      dist_t loc_lb[], int settled[], int loc_n) {
+   int i, u, v, r, e;
+   dist_t u_dist, new_dist, new_lb;
+   weight_t w;
+
+   for (i = 0; i < count; i++) {
+      u = band[i].v;
+      u_dist = band[i].dist;
+      if (loc_g != NULL) {
+         r = Find_row(loc_g, u);
+         if (r < 0) continue;
+         for (e = loc_g->row_ptr[r]; e < loc_g->row_ptr[r+1]; e++) {
+            v = loc_g->cols[e];
+            if (settled[v]) continue;
+            w = loc_g->wts[e];
+            new_dist = DIST_ADD(u_dist, w);
+            if (new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+            }
+            new_lb = DIST_ADD(lb_dist, w);
+            if (new_lb < loc_lb[v]) loc_lb[v] = new_lb;
+         }
+      } else {
+#        ifdef _OPENMP
+#        pragma omp parallel for private(w, new_dist, new_lb) \
+            if (loc_n >= OMP_MIN_N)
+#        endif
+         for (v = 0; v < loc_n; v++) {
+            w = loc_mat[(size_t) u*loc_n + v];
+            if (w >= NO_EDGE || settled[v]) continue;
+            new_dist = DIST_ADD(u_dist, w);
+            if (new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+            }
+            new_lb = DIST_ADD(lb_dist, w);
+            if (new_lb < loc_lb[v]) loc_lb[v] = new_lb;
+         }
+      }
+   }
+}  /* Relax_band */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Clip_radius
+ * Purpose:     Mark the vertices farther than radius from src as 
+ *              unreachable.  See note 27.
+ * In args:     loc_n:  size of loc_dist[] and loc_pred[]
+ *              radius:  the search radius
+ *              src:  the source vertex
+ * In/out args: loc_dist, loc_pred:  local distances and predecessors
+ */
+void Clip_radius(dist_t loc_dist[], int loc_pred[], int loc_n, 
+      dist_t radius, int src) {
+   int v;
+
+   for (v = 0; v < loc_n; v++)
+      if (loc_dist[v] > radius) {
+         loc_dist[v] = INFINITY;
+         loc_pred[v] = src;
+      }
+}  /* Clip_radius */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_sources
+ * Purpose:   Read the list of sources for batch mode on process 0 and
+ *            broadcast it to the other processes
+ * In args:   fname:  a text file of vertices separated by white space
+ *            n:  the number of vertices
+ *            my_rank:  the calling process' rank
+ *            comm:  Communicator consisting of all the processes
+ * Out arg:   count_p:  the number of sources
+ * Ret val:   The sources.  The caller should free them.
+ */
+int* Read_sources(char fname[], int n, int* count_p, int my_rank, 
+      MPI_Comm comm) {
+   int *srcs = NULL, size = 0, count = 0, local_ok = 1, s;
+   FILE* fp;
+
+   if (my_rank == 0) {
+      fp = fopen(fname, "r");
+      if (fp == NULL) {
+         local_ok = 0;
+      } else {
+         while (fscanf(fp, "%d", &s) == 1) {
+            if (s < 0 || s >= n) {
+               local_ok = 0;
+               break;
+            }
+            if (count == size) {
+               size = (size == 0) ? 64 : 2*size;
+               srcs = realloc(srcs, size*sizeof(int));
+            }
+            srcs[count++] = s;
+         }
+         fclose(fp);
+      }
+   }
+   Check_for_error(local_ok, "Can't read the list of sources", comm);
+
+   MPI_Bcast(&count, 1, MPI_INT, 0, comm);
+   COUNT_COLL(sizeof(int));
+   if (my_rank != 0) srcs = malloc(count*sizeof(int));
+   MPI_Bcast(srcs, count, MPI_INT, 0, comm);
+   COUNT_COLL(count*sizeof(int));
+
+   *count_p = count;
+   return srcs;
+}  /* Read_sources */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_batch
+ * Purpose:     Apply Dijkstra's algorithm from k sources at once.  
+ *              See note 6.
+ * In args:     loc_mat:  the calling process' block column, or NULL
+ *                 in sparse mode
+ *              loc_g:  the calling process' CSR block, or NULL in
+ *                 dense mode
+ *              srcs:  the k sources
+ *              loc_n:  the number of vertices owned by each process
+ *              my_first:  the first vertex owned by the process
+ *              n:  the number of vertices
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  k subarrays of loc_n distances, one for 
+ *                 each source
+ *              loc_pred:  k subarrays of loc_n predecessors
+ */
+void Dijkstra_batch(weight_t loc_mat[], csr_t* loc_g, int srcs[], int k, 
+      dist_t loc_dist[], int loc_pred[], int loc_n, int my_first, int n, 
+      MPI_Comm comm) {
+   int i, j, v, loc_u, u, live, *known, *known_j;
+   dist_t *dist_j;
+   pair_t *my_min, *glbl_min;
+   heap_t *heaps = NULL, *heap_j = NULL;
+   double t0;
+
+   known = malloc((size_t) k*loc_n*sizeof(int));
+   my_min = malloc(k*sizeof(pair_t));
+   glbl_min = malloc(k*sizeof(pair_t));
+
+   /* In sparse mode each source has its own frontier (note 9) */
+   if (loc_g != NULL) heaps = malloc(k*sizeof(heap_t));
+
+   for (j = 0; j < k; j++) {
+      dist_j = &loc_dist[(size_t) j*loc_n];
+      known_j = &known[(size_t) j*loc_n];
+      for (v = 0; v < loc_n; v++) {
+         dist_j[v] = INFINITY;
+         loc_pred[(size_t) j*loc_n + v] = srcs[j];
+         known_j[v] = 0;
+      }
+      if (heaps != NULL) {
+         heap_j = &heaps[j];
+         Heap_init(heap_j, dist_j, loc_n);
+      }
+      if (OWNS(my_first, loc_n, srcs[j])) {
+         dist_j[srcs[j] - my_first] = 0;
+         known_j[srcs[j] - my_first] = 1;
+         stats.settled++;
+      }
+      Relax_row(loc_mat, loc_g, srcs[j], 0, dist_j, 
+            &loc_pred[(size_t) j*loc_n], known_j, heap_j, loc_n);
+   }
+
+   for (i = 1; i < n; i++) {
+      TIC(t0);
+      for (j = 0; j < k; j++) {
+         dist_j = &loc_dist[(size_t) j*loc_n];
+         if (heaps != NULL)
+            loc_u = (heaps[j].size > 0) ? heaps[j].verts[0] : NO_VERTEX;
+         else
+            loc_u = Find_min_dist(dist_j, &known[(size_t) j*loc_n], loc_n);
+         if (loc_u < NO_VERTEX) {
+            my_min[j].dist = dist_j[loc_u];
+            my_min[j].v = loc_u + my_first;
+         } else {
+            my_min[j].dist = INFINITY;
+            my_min[j].v = NO_VERTEX;
+         }
+      }
+
+      TOC(t0, T_MIN);
+
+      /* One reduction finds the next vertex for every source */
+      TIC(t0);
+      Allreduce_minloc(my_min, glbl_min, k, comm);
+      COUNT_COLL((long long) k*sizeof(pair_t));
+      TOC(t0, T_COMM);
+
+      TIC(t0);
+      live = 0;
+      for (j = 0; j < k; j++) {
+         if (glbl_min[j].dist >= INFINITY) continue;
+         live = 1;
+         u = glbl_min[j].v;
+         known_j = &known[(size_t) j*loc_n];
+         heap_j = (heaps != NULL) ? &heaps[j] : NULL;
+
+         /* Ties go to the smaller vertex, so u is the top of its heap */
+         if (OWNS(my_first, loc_n, u)) {
+            known_j[u - my_first] = 1;
+            if (heap_j != NULL) Heap_pop(heap_j);
+            stats.settled++;
+         }
+         Relax_row(loc_mat, loc_g, u, glbl_min[j].dist, 
+               &loc_dist[(size_t) j*loc_n], &loc_pred[(size_t) j*loc_n], 
+               known_j, heap_j, loc_n);
+      }
+      TOC(t0, T_RELAX);
+
+      /* The rest of the vertices can't be reached from any source */
+      if (!live) break;
+   } /* for i */
+
+   if (heaps != NULL) {
+      for (j = 0; j < k; j++)
+         Heap_free(&heaps[j]);
+      free(heaps);
+   }
+   free(known);
+   free(my_min);
+   free(glbl_min);
+}  /* Dijkstra_batch */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_row
+ * Purpose:     Relax the edges out of the newly settled vertex u that
+ *              end in the calling process' block, in either dense or
+ *              sparse mode
+ * In args:     loc_mat:  the block column, or NULL in sparse mode
+ *              loc_g:  the CSR block, or NULL in dense mode
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path to u
+ *              known:  known[v] = 1 if the shortest path to v is known
+ *              loc_n:  the number of vertices in the block
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ *              heap:  in sparse mode, the local frontier, or NULL
+ */
+void Relax_row(weight_t loc_mat[], csr_t* loc_g, int u, dist_t u_dist, 
+      dist_t loc_dist[], int loc_pred[], int known[], heap_t* heap, 
+      int loc_n) {
+   int v;
+   dist_t new_dist;
+
+   if (loc_g != NULL) {
+      Relax_sparse(loc_g, u, u_dist, loc_dist, loc_pred, known, 1, heap);
+      return;
+   }
+
+#  ifdef _OPENMP
+#  pragma omp parallel for private(new_dist) if (loc_n >= OMP_MIN_N)
+#  endif
+   for (v = 0; v < loc_n; v++) {
+      if (!known[v] && loc_mat[(size_t) u*loc_n + v] < NO_EDGE) {
+         new_dist = DIST_ADD(u_dist, loc_mat[(size_t) u*loc_n + v]);
+         if (new_dist < loc_dist[v]) {
+            loc_dist[v] = new_dist;
+            loc_pred[v] = u;
+         }
+      }
+   }
+}  /* Relax_row */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Find_min_dist_bits
+ * Purpose:     Find the vertex u with minimum distance to src among
+ *              the vertices whose distance to src is not known, with
+ *              known stored as a bitmap.  See note 8.
+ * In args:     loc_dist:  loc_dist[v] = current estimate of distance
+ *                 src->v
+ *              known:  bit v is set if the distance src->v is known
+ *              loc_n:  the number of vertices in each process
+ * Ret val:     The local vertex with minimum distance, or NO_VERTEX 
+ *              if every vertex is known or unreachable.  Ties go to 
+ *              the smaller vertex.
+ */
+int Find_min_dist_bits(dist_t loc_dist[], uint32_t known[], int loc_n) {
+   int loc_u = NO_VERTEX;
+   dist_t loc_min_dist = INFINITY;
+
+#  ifdef _OPENMP
+#  pragma omp parallel if (loc_n >= OMP_MIN_N)
+#  endif
+   {
+      int first, last, my_u;
+      dist_t my_min_dist;
+
+      Thread_range(loc_n, &first, &last);
+      Min_range(loc_dist, known, first, last, &my_u, &my_min_dist);
+
+#     ifdef _OPENMP
+#     pragma omp critical
+#     endif
+      if (my_min_dist < loc_min_dist 
+            || (my_min_dist == loc_min_dist && my_u < loc_u)) {
+         loc_u = my_u;
+         loc_min_dist = my_min_dist;
+      }
+   }
+
+   return loc_u;
+}  /* Find_min_dist_bits */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_dense
+ * Purpose:     Relax the edges out of the newly settled vertex u into
+ *              the calling process' block column, with known stored
+ *              as a bitmap.  See note 8.
+ * In args:     row:  row u of the block column
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path src->u
+ *              known:  bit v is set if the distance src->v is known
+ *              loc_n:  the number of vertices in each process
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ *
+ * Note:        With AVX-512 or AVX2 the kernel compares against the
+ *              known bits with masks and updates loc_dist and loc_pred
+ *              with branchless blends.  Narrow weights are widened to
+ *              32-bit lanes, the lanes holding NO_EDGE are masked out,
+ *              and the sums are clamped at INFINITY.
+ */
+void Relax_dense(weight_t row[], int u, dist_t u_dist, dist_t loc_dist[], 
+      int loc_pred[], uint32_t known[], int loc_n) {
+#  ifdef _OPENMP
+#  pragma omp parallel if (loc_n >= OMP_MIN_N)
+#  endif
+   {
+      int first, last;
+
+      Thread_range(loc_n, &first, &last);
+      Relax_range(row, u, u_dist, loc_dist, loc_pred, known, first, last);
+   }
+}  /* Relax_dense */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Thread_range
+ * Purpose:     Split 0, 1, ..., loc_n-1 into one block per thread.
+ *              Each block starts at a multiple of 32, so no two
+ *              threads share a word of the known bitmap.
+ * In arg:      loc_n:  the number of vertices
+ * Out args:    first_p, last_p:  the calling thread's block is
+ *                 first, ..., last-1
+ */
+void Thread_range(int loc_n, int* first_p, int* last_p) {
+   int words = KNOWN_WORDS(loc_n), my_words, t = 0, thread_count = 1;
+
+#  ifdef _OPENMP
+   t = omp_get_thread_num();
+   thread_count = omp_get_num_threads();
+#  endif
+   my_words = (words + thread_count - 1)/thread_count;
+   *first_p = 32*t*my_words;
+   *last_p = 32*(t + 1)*my_words;
+   if (*first_p > loc_n) *first_p = loc_n;
+   if (*last_p > loc_n) *last_p = loc_n;
+}  /* Thread_range */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Min_range
+ * Purpose:     Find the unknown vertex with minimum distance among
+ *              first, ..., last-1
+ * In args:     loc_dist:  current distance estimates
+ *              known:  the known bitmap
+ *              first:  a multiple of 32
+ *              last:  one past the last vertex to examine
+ * Out args:    u_p:  the vertex with minimum distance, or NO_VERTEX
+ *              min_p:  its distance, or INFINITY
+ */
+void Min_range(dist_t loc_dist[], uint32_t known[], int first, int last,
+      int* u_p, dist_t* min_p) {
+   int v = first, u = NO_VERTEX;
+   dist_t min_dist = INFINITY;
+
+#  if defined(USE_AVX512)
+   __m512i best = _mm512_set1_epi32(INFINITY);
+   __m512i best_v = _mm512_set1_epi32(NO_VERTEX);
+   __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(first),
+         _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 
+                           8, 9, 10, 11, 12, 13, 14, 15));
+   __mmask16 unknown, lt;
+
+   for (; v + 16 <= last; v += 16) {
+      unknown = (__mmask16) ~(known[v >> 5] >> (v & 31));
+      lt = _mm512_mask_cmplt_epi32_mask(unknown, 
+            _mm512_loadu_si512(&loc_dist[v]), best);
+      best = _mm512_mask_loadu_epi32(best, lt, &loc_dist[v]);
+      best_v = _mm512_mask_mov_epi32(best_v, lt, idx);
+      idx = _mm512_add_epi32(idx, _mm512_set1_epi32(16));
+   }
+   min_dist = _mm512_reduce_min_epi32(best);
+   if (min_dist < INFINITY)
+      u = _mm512_mask_reduce_min_epi32(
+            _mm512_cmpeq_epi32_mask(best, _mm512_set1_epi32(min_dist)), 
+            best_v);
+#  elif defined(USE_AVX2)
+   __m256i best = _mm256_set1_epi32(INFINITY);
+   __m256i best_v = _mm256_set1_epi32(NO_VERTEX);
+   __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(first),
+         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+   __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+   __m256i d, known_lanes, lt;
+   int lane, lane_min[8], lane_v[8];
+
+   for (; v + 8 <= last; v += 8) {
+      known_lanes = _mm256_and_si256(lane_bits, 
+            _mm256_set1_epi32(known[v >> 5] >> (v & 31)));
+      known_lanes = _mm256_cmpeq_epi32(known_lanes, lane_bits);
+      d = _mm256_loadu_si256((__m256i*) &loc_dist[v]);
+      lt = _mm256_andnot_si256(known_lanes, _mm256_cmpgt_epi32(best, d));
+      best = _mm256_blendv_epi8(best, d, lt);
+      best_v = _mm256_blendv_epi8(best_v, idx, lt);
+      idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+   }
+   _mm256_storeu_si256((__m256i*) lane_min, best);
+   _mm256_storeu_si256((__m256i*) lane_v, best_v);
+   for (lane = 0; lane < 8; lane++)
+      if (lane_min[lane] < min_dist 
+            || (lane_min[lane] == min_dist && lane_v[lane] < u)) {
+         min_dist = lane_min[lane];
+         u = lane_v[lane];
+      }
+   if (min_dist == INFINITY) u = NO_VERTEX;
+#  endif
+
+   /* The rest of the range, or all of it without SIMD */
+   for (; v < last; v++)
+      if (!IS_KNOWN(known, v) && loc_dist[v] < min_dist) {
+         u = v;
+         min_dist = loc_dist[v];
+      }
+
+   *u_p = u;
+   *min_p = min_dist;
+}  /* Min_range */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_range
+ * Purpose:     Relax the edges out of u into the unknown vertices
+ *              first, ..., last-1
+ * In args:     row:  row u of the block column
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path to u
+ *              known:  the known bitmap
+ *              first:  a multiple of 32
+ *              last:  one past the last vertex to relax
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ */
+void Relax_range(weight_t row[], int u, dist_t u_dist, dist_t loc_dist[], 
+      int loc_pred[], uint32_t known[], int first, int last) {
+   int v = first;
+   dist_t new_dist;
+
+#  if defined(USE_AVX512)
+   __m512i u_dists = _mm512_set1_epi32(u_dist);
+   __m512i us = _mm512_set1_epi32(u);
+   __m512i new_dists, w;
+   __mmask16 unknown, lt;
+#  ifdef NARROW_WEIGHTS
+   __m512i no_edges = _mm512_set1_epi32(NO_EDGE);
+   __m512i infs = _mm512_set1_epi32(INFINITY);
+#  endif
+
+   for (; v + 16 <= last; v += 16) {
+      unknown = (__mmask16) ~(known[v >> 5] >> (v & 31));
+      w = LOAD_WTS_16(&row[v]);
+#     ifdef NARROW_WEIGHTS
+      unknown &= _mm512_cmpneq_epi32_mask(w, no_edges);
+      new_dists = _mm512_min_epu32(_mm512_add_epi32(u_dists, w), infs);
+#     else
+      new_dists = _mm512_add_epi32(u_dists, w);
+#     endif
+      lt = _mm512_mask_cmplt_epi32_mask(unknown, new_dists,
+            _mm512_loadu_si512(&loc_dist[v]));
+      _mm512_mask_storeu_epi32(&loc_dist[v], lt, new_dists);
+      _mm512_mask_storeu_epi32(&loc_pred[v], lt, us);
+   }
+#  elif defined(USE_AVX2)
+   __m256i u_dists = _mm256_set1_epi32(u_dist);
+   __m256i us = _mm256_set1_epi32(u);
+   __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+   __m256i new_dists, w, d, known_lanes, lt;
+#  ifdef NARROW_WEIGHTS
+   __m256i no_edges = _mm256_set1_epi32(NO_EDGE);
+   __m256i infs = _mm256_set1_epi32(INFINITY);
+#  endif
+
+   for (; v + 8 <= last; v += 8) {
+      known_lanes = _mm256_and_si256(lane_bits, 
+            _mm256_set1_epi32(known[v >> 5] >> (v & 31)));
+      known_lanes = _mm256_cmpeq_epi32(known_lanes, lane_bits);
+      w = LOAD_WTS_8(&row[v]);
+#     ifdef NARROW_WEIGHTS
+      /* Lanes without an edge are skipped like known ones */
+      known_lanes = _mm256_or_si256(known_lanes, 
+            _mm256_cmpeq_epi32(w, no_edges));
+      new_dists = _mm256_min_epu32(_mm256_add_epi32(u_dists, w), infs);
+#     else
+      new_dists = _mm256_add_epi32(u_dists, w);
+#     endif
+      d = _mm256_loadu_si256((__m256i*) &loc_dist[v]);
+      lt = _mm256_andnot_si256(known_lanes, _mm256_cmpgt_epi32(d, new_dists));
+      _mm256_storeu_si256((__m256i*) &loc_dist[v], 
+            _mm256_blendv_epi8(d, new_dists, lt));
+      _mm256_storeu_si256((__m256i*) &loc_pred[v], 
+            _mm256_blendv_epi8(_mm256_loadu_si256((__m256i*) &loc_pred[v]),
+               us, lt));
+   }
+#  endif
+
+   /* The rest of the range, or all of it without SIMD */
+   for (; v < last; v++) {
+      new_dist = DIST_ADD(u_dist, row[v]);
+      if (!IS_KNOWN(known, v) && row[v] < NO_EDGE 
+            && new_dist < loc_dist[v]) {
+         loc_dist[v] = new_dist;
+         loc_pred[v] = u;
+      }
+   }
+}  /* Relax_range */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_less
+ * Purpose:     Compare two vertices in heap order:  by distance, and
+ *              then by index
+ */
+static int Heap_less(heap_t* heap, int v, int w) {
+   return heap->keys[v] < heap->keys[w] 
+      || (heap->keys[v] == heap->keys[w] && v < w);
+}  /* Heap_less */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_place
+ * Purpose:     Store vertex v in slot i of the heap
+ */
+static void Heap_place(heap_t* heap, int i, int v) {
+   heap->verts[i] = v;
+   heap->pos[v] = i;
+}  /* Heap_place */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_init
+ * Purpose:     Create an empty heap for the vertices 0, ..., loc_n-1
+ * In args:     keys:  the distances the heap is ordered by.  The 
+ *                 heap keeps a pointer to them.
+ *              loc_n:  the number of vertices
+ * Out arg:     heap:  the heap
+ */
+void Heap_init(heap_t* heap, dist_t keys[], int loc_n) {
+   int v;
+
+   heap->size = 0;
+   heap->keys = keys;
+   heap->verts = malloc(loc_n*sizeof(int));
+   heap->pos = malloc(loc_n*sizeof(int));
+   for (v = 0; v < loc_n; v++)
+      heap->pos[v] = -1;
+}  /* Heap_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_free
+ * Purpose:     Free the storage allocated by Heap_init
+ */
+void Heap_free(heap_t* heap) {
+   free(heap->verts);
+   free(heap->pos);
+}  /* Heap_free */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_clear
+ * Purpose:     Empty a heap in time proportional to its size, and 
+ *              order it by new keys
+ * In arg:      keys:  the distances the heap will be ordered by
+ * In/out arg:  heap:  the heap
+ */
+void Heap_clear(heap_t* heap, dist_t keys[]) {
+   int i;
+
+   for (i = 0; i < heap->size; i++)
+      heap->pos[heap->verts[i]] = -1;
+   heap->size = 0;
+   heap->keys = keys;
+}  /* Heap_clear */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_update
+ * Purpose:     Insert v into the heap, or move it up after its key
+ *              has decreased
+ * In arg:      v:  a vertex
+ * In/out arg:  heap:  the heap
+ */
+void Heap_update(heap_t* heap, int v) {
+   int i = heap->pos[v], parent;
+
+   if (i < 0) i = heap->size++;
+   while (i > 0) {
+      parent = (i - 1)/HEAP_D;
+      if (!Heap_less(heap, v, heap->verts[parent])) break;
+      Heap_place(heap, i, heap->verts[parent]);
+      i = parent;
+   }
+   Heap_place(heap, i, v);
+}  /* Heap_update */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Heap_pop
+ * Purpose:     Remove the vertex with the smallest key from the heap
+ * In/out arg:  heap:  a nonempty heap
+ * Ret val:     The vertex that was removed
+ */
+int Heap_pop(heap_t* heap) {
+   int top = heap->verts[0], last, i = 0, child, c, best;
+
+   heap->pos[top] = -1;
+   heap->size--;
+   if (heap->size == 0) return top;
+
+   last = heap->verts[heap->size];
+   for (;;) {
+      child = HEAP_D*i + 1;
+      if (child >= heap->size) break;
+      best = child;
+      for (c = child + 1; c < child + HEAP_D && c < heap->size; c++)
+         if (Heap_less(heap, heap->verts[c], heap->verts[best]))
+            best = c;
+      if (!Heap_less(heap, heap->verts[best], last)) break;
+      Heap_place(heap, i, heap->verts[best]);
+      i = best;
+   }
+   Heap_place(heap, i, last);
+
+   return top;
+}  /* Heap_pop */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Is_target
+ * Purpose:     Determine whether v is one of the targets
+ * In args:     v:  a global vertex
+ *              targets:  sorted list of targets, or NULL
+ *              n_targets:  the number of targets
+ * Ret val:     1 if v is a target, 0 otherwise
+ */
+int Is_target(int v, int targets[], int n_targets) {
+   int lo = 0, hi = n_targets - 1, mid;
+
+   while (lo <= hi) {
+      mid = lo + (hi - lo)/2;
+      if (targets[mid] == v)
+         return 1;
+      else if (targets[mid] < v)
+         lo = mid + 1;
+      else
+         hi = mid - 1;
+   }
+   return 0;
+}  /* Is_target */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Compare_ints
+ * Purpose:     qsort comparison function for ints
+ */
+static int Compare_ints(const void* a, const void* b) {
+   int x = *(const int*) a, y = *(const int*) b;
+
+   return (x > y) - (x < y);
+}  /* Compare_ints */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Parse_targets
+ * Purpose:     Convert a comma-separated list of vertices into a 
+ *              sorted list without duplicates
+ * In arg:      list:  the list from the command line
+ * Out arg:     n_targets_p:  the number of targets
+ * Ret val:     The targets, or NULL if the list isn't valid
+ */
+int* Parse_targets(char list[], int* n_targets_p) {
+   int *targets, count = 1, i, j;
+   char *cp, *end;
+
+   for (cp = list; *cp != '\0'; cp++)
+      if (*cp == ',') count++;
+   targets = malloc(count*sizeof(int));
+
+   cp = list;
+   for (i = 0; i < count; i++) {
+      targets[i] = strtol(cp, &end, 10);
+      if (end == cp || targets[i] < 0 || (*end != ',' && *end != '\0')) {
+         free(targets);
+         return NULL;
+      }
+      cp = end + 1;
+   }
+
+   qsort(targets, count, sizeof(int), Compare_ints);
+   for (i = j = 1; i < count; i++)
+      if (targets[i] != targets[j-1])
+         targets[j++] = targets[i];
+
+   *n_targets_p = j;
+   return targets;
+}  /* Parse_targets */
+
+
+
+/*---------------------------------------------------------------------
+ * Function:  Build_loc_col_type
+ * Purpose:   Build an MPI_Datatype that represents one column of an
+ *            n x loc_n block stored by rows.  Receiving a column of 
+ *            the matrix with it stores it as a column of loc_mat, 
+ *            and receiving a row stores it as a column of loc_tr 
+ *            (note 11).
+ * In args:   n:  number of rows in the block
+ *            loc_n:  number of columns in the block
+ * Ret val:   loc_col_mpi_t:  MPI_Datatype that puts n weights loc_n
+ *            apart.  Its extent is one weight, so loc_n of them fill
+ *            the block.
+ */
+MPI_Datatype Build_loc_col_type(int n, int loc_n) {
+   MPI_Datatype col_mpi_t;
+   MPI_Datatype loc_col_mpi_t;
+
+   MPI_Type_vector(n, 1, loc_n, WEIGHT_MPI, &col_mpi_t);
+   MPI_Type_create_resized(col_mpi_t, 0, sizeof(weight_t), &loc_col_mpi_t);
+   MPI_Type_commit(&loc_col_mpi_t);
+
+   MPI_Type_free(&col_mpi_t);
+
+   return loc_col_mpi_t;
+}  /* Build_loc_col_type */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Build_edge_type
+ * Purpose:   Build an MPI_Datatype that represents an edge_t
+ * Ret val:   edge_mpi_t:  two ints followed by a weight_t, with the
+ *            extent of an edge_t so that arrays of edges can be sent
+ */
+MPI_Datatype Build_edge_type(void) {
+   int blk_lens[2] = {2, 1};
+   MPI_Aint displs[2] = {offsetof(edge_t, u), offsetof(edge_t, w)};
+   MPI_Datatype types[2] = {MPI_INT, WEIGHT_MPI};
+   MPI_Datatype struct_mpi_t;
+   MPI_Datatype edge_mpi_t;
+
+   MPI_Type_create_struct(2, blk_lens, displs, types, &struct_mpi_t);
+   MPI_Type_create_resized(struct_mpi_t, 0, sizeof(edge_t), &edge_mpi_t);
+   MPI_Type_commit(&edge_mpi_t);
+
+   MPI_Type_free(&struct_mpi_t);
+
+   return edge_mpi_t;
+}  /* Build_edge_type */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Build_part
+ * Purpose:   Split the n vertices into p contiguous blocks whose
+ *            sizes differ by at most one
+ * In args:   n:  the number of vertices
+ *            p:  the number of processes
+ * Out arg:   part:  the blocks.  Free it with Free_part.
+ *
+ * Note:      The first n % p processes get n/p + 1 vertices and the
+ *            rest n/p.
+ */
+void Build_part(int n, int p, part_t* part) {
+   int q;
+
+   part->p = p;
+   part->first = malloc((p + 1)*sizeof(int));
+   part->counts = malloc(p*sizeof(int));
+   for (q = 0; q <= p; q++) 
+      part->first[q] = q*(n/p) + ((q < n % p) ? q : n % p);
+   for (q = 0; q < p; q++)
+      part->counts[q] = part->first[q+1] - part->first[q];
+}  /* Build_part */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Free_part
+ * Purpose:   Free the arrays allocated by Build_part
+ */
+void Free_part(part_t* part) {
+   free(part->first);
+   free(part->counts);
+}  /* Free_part */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Owner
+ * Purpose:   Find the process that owns global vertex v
+ * In args:   part:  the blocks
+ *            v:  a vertex, 0 <= v < n
+ * Ret val:   q such that part->first[q] <= v < part->first[q+1].
+ *            Empty blocks are skipped.
+ */
+int Owner(part_t* part, int v) {
+   int lo = 0, hi = part->p - 1, mid;
+
+   while (lo < hi) {
+      mid = (lo + hi + 1)/2;
+      if (part->first[mid] <= v)
+         lo = mid;
+      else
+         hi = mid - 1;
+   }
+   return lo;
+}  /* Owner */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Balance_part
+ * Purpose:   Move the block boundaries so that every process owns 
+ *            about the same number of edges plus vertices.  See
+ *            note 13.
+ * In args:   cols_ptr:  n+1 offsets, cols_ptr[v+1] - cols_ptr[v] is
+ *               the number of edges into v and cols_ptr[0] = 0
+ * In/out:    part:  blocks built by Build_part for n vertices
+ *
+ * Note:      Vertex v ends at cost cols_ptr[v+1] + v + 1, which is
+ *            strictly increasing, so block q starts at the first v 
+ *            whose cost reaches q/p of the total.
+ */
+void Balance_part(part_t* part, const int64_t cols_ptr[]) {
+   int p = part->p, n = part->first[p], q, lo, hi, mid;
+   int64_t total = cols_ptr[n] + n, goal;
+
+   for (q = 1; q < p; q++) {
+      goal = total*q/p;
+      lo = part->first[q-1];
+      hi = n;
+      while (lo < hi) {
+         mid = lo + (hi - lo)/2;
+         if (cols_ptr[mid] + mid >= goal)
+            hi = mid;
+         else
+            lo = mid + 1;
+      }
+      part->first[q] = lo;
+   }
+   for (q = 0; q < p; q++)
+      part->counts[q] = part->first[q+1] - part->first[q];
+}  /* Balance_part */
+
+
+
+/*---------------------------------------------------------------------
+ * Function:  Load_dense_tr
+ * Purpose:   Copy the calling process' block column of the transpose
+ *            out of a mapped LAYOUT_DENSE graph file
+ * In args:   map:  the mapping returned by Map_graph
+ *            n:  the number of rows in the matrix
+ *            loc_n:  the number of rows in the block row
+ *            my_first:  the first row of the block row
+ * Out arg:   loc_tr:  the calling process' block column of the 
+ *               transpose
+ */
+void Load_dense_tr(void* map, weight_t loc_tr[], int n, int loc_n, 
+      int my_first) {
+   const weight_t* mat = (const weight_t*) ((char*) map 
+         + sizeof(graph_hdr_t));
+   size_t u, v, first = my_first;
+
+   for (v = 0; v < loc_n; v++)
+      for (u = 0; u < n; u++)
+         loc_tr[u*loc_n + v] = mat[(first + v)*n + u];
+}  /* Load_dense_tr */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_dense_tr_all
+ * Purpose:   Read each process' block row of a LAYOUT_DENSE graph 
+ *            file into its block column of the transpose with one
+ *            collective read
+ * In args:   fh:  the file opened by Open_graph
+ *            n:  the number of rows in the matrix
+ *            loc_n:  the number of rows in the block row
+ *            loc_col_mpi_t:  the MPI_Datatype built by 
+ *               Build_loc_col_type
+ *            my_first:  the first row of the block row
+ * Out arg:   loc_tr:  the calling process' block column of the 
+ *               transpose
+ */
+void Read_dense_tr_all(MPI_File fh, weight_t loc_tr[], int n, int loc_n,
+      MPI_Datatype loc_col_mpi_t, int my_first) {
+   MPI_File_set_view(fh, sizeof(graph_hdr_t), WEIGHT_MPI, WEIGHT_MPI, 
+         "native", MPI_INFO_NULL);
+   MPI_File_read_at_all(fh, (MPI_Offset) my_first*n, loc_tr, loc_n,
+         loc_col_mpi_t, MPI_STATUS_IGNORE);
+}  /* Read_dense_tr_all */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_bidir
+ * Purpose:     Find the shortest path src->t by searching forward
+ *              from src and backward from t.  See note 11.
+ * In args:     loc_mat:  the calling process' block column
+ *              loc_tr:  the calling process' block column of the 
+ *                 transpose
+ *              loc_n:  the number of vertices owned by each process
+ *              my_first:  the first vertex owned by the process
+ *              src:  the source
+ *              t:  the target
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  forward distances from src
+ *              loc_pred:  loc_pred[v] = the vertex before v on the 
+ *                 forward path src->v
+ *              loc_succ:  loc_succ[v] = the vertex after v on the 
+ *                 backward path v->t
+ *              mu_p:  the length of the shortest path src->t, or 
+ *                 INFINITY
+ *              meet_p:  a vertex on that path where the forward and 
+ *                 backward paths meet
+ *
+ * Note:        my_min[0] and my_min[1] are the forward and backward 
+ *              frontier minima and my_min[2] is (mu, meet), the 
+ *              length of the best path found so far and the vertex
+ *              where its halves meet, so one reduction finds all 
+ *              three.  The search stops when the two minima add up 
+ *              to at least mu.
+ */
+void Dijkstra_bidir(weight_t loc_mat[], weight_t loc_tr[], 
+      dist_t loc_dist[], int loc_pred[], int loc_succ[], int loc_n, 
+      int my_first, int src, int t, dist_t* mu_p, int* meet_p, 
+      MPI_Comm comm) {
+   int loc_u, v;
+   dist_t *loc_bdist, sum;
+   pair_t my_min[3], glbl_min[3];
+   uint32_t *known, *bknown;
+   double t0;
+
+   /* Forward and backward distances and known bitmaps */
+   loc_bdist = malloc(loc_n*sizeof(dist_t));
+   known = calloc(KNOWN_WORDS(loc_n), sizeof(uint32_t));
+   bknown = calloc(KNOWN_WORDS(loc_n), sizeof(uint32_t));
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = loc_bdist[v] = INFINITY;
+      loc_pred[v] = src;
+      loc_succ[v] = t;
+   }
+   if (OWNS(my_first, loc_n, src)) {
+      loc_dist[src - my_first] = 0;
+      SET_KNOWN(known, src - my_first);
+      stats.settled++;
+   }
+   if (OWNS(my_first, loc_n, t)) {
+      loc_bdist[t - my_first] = 0;
+      SET_KNOWN(bknown, t - my_first);
+      stats.settled++;
+   }
+   Relax_dense(&loc_mat[(size_t) src*loc_n], src, 0, loc_dist, loc_pred, 
+         known, loc_n);
+   Relax_dense(&loc_tr[(size_t) t*loc_n], t, 0, loc_bdist, loc_succ, 
+         bknown, loc_n);
+
+   for (;;) {
+      /* Best meeting point among this process' vertices */
+      TIC(t0);
+      my_min[2].dist = INFINITY;
+      my_min[2].v = NO_VERTEX;
+      for (v = 0; v < loc_n; v++) {
+         sum = DIST_ADD(loc_dist[v], loc_bdist[v]);
+         if (sum < my_min[2].dist) {
+            my_min[2].dist = sum;
+            my_min[2].v = v + my_first;
+         }
+      }
+
+      loc_u = Find_min_dist_bits(loc_dist, known, loc_n);
+      my_min[0].dist = (loc_u < NO_VERTEX) ? loc_dist[loc_u] : INFINITY;
+      my_min[0].v = (loc_u < NO_VERTEX) ? loc_u + my_first : NO_VERTEX;
+      loc_u = Find_min_dist_bits(loc_bdist, bknown, loc_n);
+      my_min[1].dist = (loc_u < NO_VERTEX) ? loc_bdist[loc_u] : INFINITY;
+      my_min[1].v = (loc_u < NO_VERTEX) ? loc_u + my_first : NO_VERTEX;
+
+      TOC(t0, T_MIN);
+
+      TIC(t0);
+      Allreduce_minloc(my_min, glbl_min, 3, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+
+      /* No shorter path can be found */
+      if (glbl_min[0].dist >= INFINITY || glbl_min[1].dist >= INFINITY 
+            || DIST_ADD(glbl_min[0].dist, glbl_min[1].dist) 
+               >= glbl_min[2].dist)
+         break;
+
+      TIC(t0);
+      if (OWNS(my_first, loc_n, glbl_min[0].v)) {
+         SET_KNOWN(known, glbl_min[0].v - my_first);
+         stats.settled++;
+      }
+      Relax_dense(&loc_mat[(size_t) glbl_min[0].v*loc_n], glbl_min[0].v, 
+            glbl_min[0].dist, loc_dist, loc_pred, known, loc_n);
+
+      if (OWNS(my_first, loc_n, glbl_min[1].v)) {
+         SET_KNOWN(bknown, glbl_min[1].v - my_first);
+         stats.settled++;
+      }
+      Relax_dense(&loc_tr[(size_t) glbl_min[1].v*loc_n], glbl_min[1].v, 
+            glbl_min[1].dist, loc_bdist, loc_succ, bknown, loc_n);
+      TOC(t0, T_RELAX);
+   }
+
+   *mu_p = (glbl_min[2].dist < INFINITY) ? glbl_min[2].dist : INFINITY;
+   *meet_p = glbl_min[2].v;
+
+   free(loc_bdist);
+   free(known);
+   free(bknown);
+}  /* Dijkstra_bidir */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Print_bidir
+ * Purpose:     Print the distance and the path found by 
+ *              Dijkstra_bidir in the same format as Print_dists and
+ *              Print_paths
+ * In args:     loc_pred, loc_succ:  the forward predecessors and 
+ *                 backward successors
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              src, t:  the ends of the path
+ *              mu:  the length of the path
+ *              meet:  the vertex where the two halves meet
+ *              my_rank:  the calling process' rank
+ *              comm:  MPI Communicator
+ */
+void Print_bidir(int loc_pred[], int loc_succ[], int n, part_t* part, 
+      int src, int t, dist_t mu, int meet, int my_rank, MPI_Comm comm) {
+   int *pred = NULL, *succ = NULL, *path, count = 0, w, i;
+
+   if (my_rank == 0) {
+      pred = malloc(n*sizeof(int));
+      succ = malloc(n*sizeof(int));
+   }
+   MPI_Gatherv(loc_pred, part->counts[my_rank], MPI_INT, pred, part->counts,
+         part->first, MPI_INT, 0, comm);
+   MPI_Gatherv(loc_succ, part->counts[my_rank], MPI_INT, succ, part->counts,
+         part->first, MPI_INT, 0, comm);
+   COUNT_COLL(part->counts[my_rank]*sizeof(int));
+   COUNT_COLL(part->counts[my_rank]*sizeof(int));
+
+   if (my_rank == 0) {
+      printf("The distance from %d to each vertex is:\n", src);
+      printf("  v    dist %d->v\n", src);
+      printf("----   ---------\n");
+      if (t != src) printf("%3d       %4" DIST_FMT "\n", t, mu);
+      printf("\n");
+
+      printf("The shortest path from %d to each vertex is:\n", src);
+      printf("  v     Path %d->v\n", src);
+      printf("----    ---------\n");
+      if (t != src) {
+         path = malloc(n*sizeof(int));
+         if (mu < INFINITY) {
+            for (w = meet; w != src; w = pred[w])
+               path[count++] = w;
+         } else {
+            path[count++] = t;
+         }
+         printf("%3d:    %d ", t, src);
+         for (i = count-1; i >= 0; i--)
+            printf("%d ", path[i]);
+         if (mu < INFINITY)
+            for (w = meet; w != t; w = succ[w])
+               printf("%d ", succ[w]);
+         printf("\n");
+         free(path);
+      }
+
+      free(pred);
+      free(succ);
+   }
+}  /* Print_bidir */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Print_stats
+ * Purpose:     Write the min, max and average over the processes of
+ *              each timer and counter in stats to stderr.  See 
+ *              note 12.
+ * In args:     fmt:  "json" or "csv"
+ *              n:  the number of vertices
+ *              p:  the number of processes
+ *              my_rank:  the calling process' rank
+ *              comm:  MPI Communicator
+ */
+void Print_stats(char fmt[], int n, int p, int my_rank, MPI_Comm comm) {
+   const char* names[N_TIMERS + 3] = {"read_n", "parse", "scatter", "load",
+      "min", "comm", "relax", "output", "ckpt", "collectives", "bytes", 
+      "settled"};
+   double loc_vals[N_TIMERS + 3], mins[N_TIMERS + 3], maxs[N_TIMERS + 3];
+   double sums[N_TIMERS + 3];
+   int i, json = (strcmp(fmt, "json") == 0);
+
+   for (i = 0; i < N_TIMERS; i++)
+      loc_vals[i] = stats.t[i];
+   loc_vals[N_TIMERS] = stats.colls;
+   loc_vals[N_TIMERS + 1] = stats.bytes;
+   loc_vals[N_TIMERS + 2] = stats.settled;
+
+   MPI_Reduce(loc_vals, mins, N_TIMERS + 3, MPI_DOUBLE, MPI_MIN, 0, comm);
+   MPI_Reduce(loc_vals, maxs, N_TIMERS + 3, MPI_DOUBLE, MPI_MAX, 0, comm);
+   MPI_Reduce(loc_vals, sums, N_TIMERS + 3, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+   if (my_rank == 0) {
+      if (json)
+         fprintf(stderr, "{\"p\": %d, \"n\": %d", p, n);
+      else
+         fprintf(stderr, "name,min,max,avg\n");
+      for (i = 0; i < N_TIMERS + 3; i++)
+         if (json)
+            fprintf(stderr, ", \"%s\": {\"min\": %g, \"max\": %g, "
+                  "\"avg\": %g}", names[i], mins[i], maxs[i], sums[i]/p);
+         else
+            fprintf(stderr, "%s,%g,%g,%g\n", names[i], mins[i], maxs[i],
+                  sums[i]/p);
+      if (json) fprintf(stderr, "}\n");
+   }
+}  /* Print_stats */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_pipelined
+ * Purpose:     Apply Dijkstra's algorithm to the dense block columns
+ *              with a packed uint64 key and a non-blocking reduction.
+ *              See note 14.
+ * In args:     mat:  the calling process' block column
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances
+ *              loc_pred:  subarray of predecessors
+ *
+ * Note:        While the reduction is in flight each process finds its
+ *              runner-up, the best unknown vertex besides its
+ *              candidate.  Relaxation only lowers distances, so the
+ *              next local minimum is the smaller of the runner-up (or
+ *              the candidate, if it lost) and the smallest key
+ *              Relax_min_dense wrote.
+ */
+void Dijkstra_pipelined(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+      int loc_n, int my_first, int n, int src, int targets[], 
+      int n_targets, MPI_Comm comm) {
+   int i, loc_u, loc_w, u, v;
+   dist_t min_dist;
+   int remaining = (targets != NULL) ? n_targets : n;
+   uint64_t my_key, glbl_key, next_key, relax_key;
+   uint32_t* known;
+   MPI_Request req;
+   double t0;
+
+   known = work.known;
+   memset(known, 0, KNOWN_WORDS(loc_n)*sizeof(uint32_t));
+
+#  ifdef _OPENMP
+#  pragma omp parallel for if (loc_n >= OMP_MIN_N)
+#  endif
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = EDGE_DIST(mat[(size_t) src*loc_n + v]);
+      loc_pred[v] = src;
+   }
+   if (OWNS(my_first, loc_n, src)) {
+      loc_dist[src - my_first] = 0;
+      SET_KNOWN(known, src - my_first);
+      stats.settled++;
+   }
+   if (Is_target(src, targets, n_targets)) remaining--;
+
+   TIC(t0);
+   loc_u = Find_min_dist_bits(loc_dist, known, loc_n);
+   my_key = (loc_u < NO_VERTEX) ? KEY(loc_dist[loc_u], loc_u + my_first) 
+      : KEY_NONE;
+   TOC(t0, T_MIN);
+
+   for (i = 1; i < n && remaining > 0; i++) {
+      MPI_Iallreduce(&my_key, &glbl_key, 1, MPI_UINT64_T, MPI_MIN, comm,
+            &req);
+      COUNT_COLL(sizeof(my_key));
+
+      /* Find the runner-up while the reduction is in flight */
+      TIC(t0);
+      loc_w = NO_VERTEX;
+      if (loc_u < NO_VERTEX) {
+         SET_KNOWN(known, loc_u);
+         loc_w = Find_min_dist_bits(loc_dist, known, loc_n);
+      }
+      TOC(t0, T_MIN);
+
+      TIC(t0);
+      MPI_Wait(&req, MPI_STATUS_IGNORE);
+      TOC(t0, T_COMM);
+
+      /* The rest of the vertices can't be reached */
+      if (glbl_key == KEY_NONE) break;
+      min_dist = glbl_key >> 32;
+      u = (uint32_t) glbl_key;
+
+      /* loc_u stays known only if it won */
+      if (glbl_key == my_key) {
+         next_key = (loc_w < NO_VERTEX) 
+            ? KEY(loc_dist[loc_w], loc_w + my_first) : KEY_NONE;
+         stats.settled++;
+      } else {
+         if (loc_u < NO_VERTEX) CLEAR_KNOWN(known, loc_u);
+         next_key = my_key;
+      }
+
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+
+      TIC(t0);
+      relax_key = Relax_min_dense(&mat[(size_t) u*loc_n], u, min_dist, 
+            loc_dist, loc_pred, known, loc_n, my_first);
+      TOC(t0, T_RELAX);
+
+      my_key = (relax_key < next_key) ? relax_key : next_key;
+      loc_u = (my_key != KEY_NONE) ? (int) (uint32_t) my_key - my_first
+         : NO_VERTEX;
+   } /* for i */
+}  /* Dijkstra_pipelined */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_min_dense
+ * Purpose:     Relax the edges out of the newly settled vertex u into
+ *              the calling process' block column and find the 
+ *              smallest key among the distances that changed
+ * In args:     row:  row u of the block column
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path src->u
+ *              known:  bit v is set if the distance src->v is known
+ *              loc_n:  the number of vertices in the block
+ *              my_first:  the first vertex owned by the process
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ * Ret val:     KEY(loc_dist[v], v + my_first) for the changed v with
+ *              the smallest key, or KEY_NONE
+ */
+uint64_t Relax_min_dense(weight_t row[], int u, dist_t u_dist, 
+      dist_t loc_dist[], int loc_pred[], uint32_t known[], int loc_n, 
+      int my_first) {
+   uint64_t best = KEY_NONE;
+   int v;
+
+#  ifdef _OPENMP
+#  pragma omp parallel for reduction(min: best) if (loc_n >= OMP_MIN_N)
+#  endif
+   for (v = 0; v < loc_n; v++) {
+      dist_t new_dist = DIST_ADD(u_dist, row[v]);
+
+      if (!IS_KNOWN(known, v) && row[v] < NO_EDGE 
+            && new_dist < loc_dist[v]) {
+         loc_dist[v] = new_dist;
+         loc_pred[v] = u;
+         if (KEY(new_dist, v + my_first) < best)
+            best = KEY(new_dist, v + my_first);
+      }
+   }
+
+   return best;
+}  /* Relax_min_dense */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Create_results
+ * Purpose:     Collectively create the results file for -o and write
+ *              its header and list of sources.  See note 17.
+ * In args:     fname:  the name of the file
+ *              n:  the number of vertices
+ *              srcs:  the sources, one record each
+ *              n_srcs:  the number of sources
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * Ret val:     The open file.  The caller should close it.
+ */
+MPI_File Create_results(char fname[], int n, int srcs[], int n_srcs, 
+      int my_rank, MPI_Comm comm) {
+   MPI_File fh;
+   result_hdr_t hdr;
+   int local_ok = 1;
+
+   if (MPI_File_open(comm, fname, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+      local_ok = 0;
+      fh = MPI_FILE_NULL;
+   }
+   Check_for_error(local_ok, "Can't create the results file", comm);
+   MPI_File_set_size(fh, 0);
+
+   if (my_rank == 0) {
+      memset(&hdr, 0, sizeof(hdr));
+      memcpy(hdr.magic, RESULT_MAGIC, 4);
+      hdr.version = RESULT_VERSION;
+      hdr.dist_type = DIST_CODE;
+      hdr.n_srcs = n_srcs;
+      hdr.n = n;
+      MPI_File_write_at(fh, 0, &hdr, sizeof(hdr), MPI_BYTE, 
+            MPI_STATUS_IGNORE);
+      MPI_File_write_at(fh, sizeof(hdr), srcs, n_srcs, MPI_INT, 
+            MPI_STATUS_IGNORE);
+   }
+
+   return fh;
+}  /* Create_results */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Write_results
+ * Purpose:     Write the calling process' block of the distances and
+ *              predecessors into record rec of the results file with
+ *              two collective writes
+ * In args:     fh:  the file opened by Create_results
+ *              rec:  the index of the source in the file's list
+ *              loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors
+ *              n:  the number of vertices
+ *              n_srcs:  the number of records in the file
+ *              part:  the vertices owned by each process
+ *              my_rank:  the calling process' rank
+ */
+void Write_results(MPI_File fh, int rec, dist_t loc_dist[], int loc_pred[],
+      int n, int n_srcs, part_t* part, int my_rank) {
+   MPI_Offset base = sizeof(result_hdr_t) + (MPI_Offset) n_srcs*sizeof(int)
+      + (MPI_Offset) rec*n*(sizeof(dist_t) + sizeof(int));
+   MPI_Offset my_first = part->first[my_rank];
+   int loc_n = part->counts[my_rank];
+
+   MPI_File_write_at_all(fh, base + my_first*sizeof(dist_t), loc_dist, 
+         loc_n, DIST_MPI, MPI_STATUS_IGNORE);
+   MPI_File_write_at_all(fh, base + (MPI_Offset) n*sizeof(dist_t) 
+         + my_first*sizeof(int), loc_pred, loc_n, MPI_INT, 
+         MPI_STATUS_IGNORE);
+}  /* Write_results */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Solve
+ * Purpose:     Find the shortest paths from opts->src with the solver
+ *              selected by the options
+ * In args:     loc_mat:  the block column or, with -2, the 2D block 
+ *                 in dense mode, or NULL
+ *              loc_g:  the CSR block in sparse mode, or NULL
+ *              grid:  the process grid with -2, or NULL
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              opts:  src, targets, delta, radius, eps and the engine
+ *                 to use
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * Out args:    loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors
+ */
+void Solve(weight_t loc_mat[], csr_t* loc_g, grid_t* grid, 
+      dist_t loc_dist[], int loc_pred[], int n, part_t* part, opts_t* opts, 
+      int my_rank, MPI_Comm comm) {
+   int loc_n = part->counts[my_rank], my_first = part->first[my_rank];
+
+   if (grid != NULL)
+      Dijkstra_2d(loc_mat, loc_dist, loc_pred, grid, n, opts->src, 
+            opts->targets, opts->n_targets);
+   else if (opts->delta > 0)
+      Delta_stepping(loc_mat, loc_g, loc_dist, loc_pred, loc_n, my_first, 
+            part->p, opts->delta, opts->src, opts->radius, opts->targets, 
+            opts->n_targets, comm);
+   else if (opts->eps > 0)
+      Dijkstra_approx(loc_mat, loc_g, loc_dist, loc_pred, loc_n, my_first, 
+            part->p, opts->eps, opts->src, opts->radius, opts->targets, 
+            opts->n_targets, comm);
+   else if (loc_g != NULL)
+      Dijkstra_sparse(loc_g, loc_dist, loc_pred, loc_n, my_first, n, 
+            opts->src, opts->radius, opts->targets, opts->n_targets, comm);
+#  ifdef INT_DIST
+   else if (opts->device)
+      Dijkstra_device(loc_mat, loc_dist, loc_pred, loc_n, my_first, n, 
+            opts->src, opts->targets, opts->n_targets, comm);
+#  endif
+#  ifdef SETTLED_BIT
+   else if (opts->fused)
+      Dijkstra_fused(loc_mat, loc_dist, loc_pred, loc_n, my_first, n, 
+            opts->src, opts->targets, opts->n_targets, comm);
+#  endif
+   else if (opts->pipelined)
+      Dijkstra_pipelined(loc_mat, loc_dist, loc_pred, loc_n, my_first, n,
+            opts->src, opts->targets, opts->n_targets, comm);
+   else
+      Dijkstra(loc_mat, loc_dist, loc_pred, loc_n, my_first, n, opts->src,
+            opts->radius, opts->targets, opts->n_targets, comm);
+
+   if (opts->radius < INFINITY)
+      Clip_radius(loc_dist, loc_pred, loc_n, opts->radius, opts->src);
+}  /* Solve */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Output_results
+ * Purpose:     Print the distances and paths found by Solve, or 
+ *              write them to opts->out_file or the tree to 
+ *              opts->tree_file
+ * In args:     loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              opts:  src, targets, out_file and tree_file
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ */
+void Output_results(dist_t loc_dist[], int loc_pred[], int n, part_t* part,
+      opts_t* opts, int my_rank, MPI_Comm comm) {
+   MPI_File fh;
+
+   if (opts->tree_file != NULL)
+      Export_tree(loc_dist, loc_pred, n, part, opts->src, opts->tree_file,
+            my_rank, comm);
+   if (opts->out_file != NULL) {
+      fh = Create_results(opts->out_file, n, &opts->src, 1, my_rank, comm);
+      Write_results(fh, 0, loc_dist, loc_pred, n, 1, part, my_rank);
+      MPI_File_close(&fh);
+   } else if (opts->tree_file == NULL) {
+      Print_dists(loc_dist, n, part, opts->src, opts->targets, 
+            opts->n_targets, my_rank, comm);
+      Print_paths(loc_pred, n, part, opts->src, opts->targets, 
+            opts->n_targets, my_rank, comm);
+   }
+}  /* Output_results */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Parse_query
+ * Purpose:     Parse one line of the query file.  See notes 18 and 19.
+ * In args:     n:  the number of vertices
+ * In/out args: line:  the query.  It's overwritten, and out_file and
+ *                 tree_file point into it.
+ *              query:  on entry the command line options.  On return
+ *                 src, targets, n_targets, delta, radius, eps, 
+ *                 out_file and tree_file are the query's.  The caller
+ *                 should free targets.
+ * Out args:    upd_p:  for an update, the new weights of the edges,
+ *                 for a path query one edge u->v, with u = -1 for
+ *                 "path v", or NULL.  The caller should free them.
+ *              n_upd_p:  the number of edges in *upd_p
+ * Ret val:     QUERY_RUN, QUERY_SKIP for a blank line or a comment,
+ *              QUERY_BAD, QUERY_QUIT, QUERY_UPDATE or QUERY_PATH
+ *
+ * Note:        A query is one of
+ *                 <src> [-t <targets>] [-D <delta>] [-R <radius>] 
+ *                    [-E <eps>] [-o <results>] [-x <tree>]
+ *                 update u1 v1 w1 u2 v2 w2 ...
+ *                 path v
+ *                 onpath u v
+ *                 quit
+ *              -D 0, -R inf and -E 0 turn those options off.
+ */
+int Parse_query(char line[], opts_t* query, int n, edge_t** upd_p, 
+      int* n_upd_p) {
+   char *tok, *arg, *end;
+   edge_t* upd;
+   int size = 0, count = 0;
+   double radius;
+
+   query->targets = NULL;
+   query->n_targets = 0;
+   query->out_file = NULL;
+   query->tree_file = NULL;
+   *upd_p = NULL;
+   *n_upd_p = 0;
+
+   tok = strtok(line, " \t\r\n");
+   if (tok == NULL || tok[0] == '#') return QUERY_SKIP;
+   if (strcmp(tok, "quit") == 0) return QUERY_QUIT;
+   if (strcmp(tok, "update") == 0) {
+      while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+         if (count == size) {
+            size = (size == 0) ? 16 : 2*size;
+            *upd_p = realloc(*upd_p, size*sizeof(edge_t));
+         }
+         upd = &(*upd_p)[count++];
+         upd->u = strtol(tok, &end, 10);
+         if (*end != '\0' || upd->u < 0 || upd->u >= n 
+               || (tok = strtok(NULL, " \t\r\n")) == NULL)
+            return QUERY_BAD;
+         upd->v = strtol(tok, &end, 10);
+         if (*end != '\0' || upd->v < 0 || upd->v >= n 
+               || (tok = strtok(NULL, " \t\r\n")) == NULL
+               || sscanf(tok, "%" WEIGHT_SCN, &upd->w) != 1)
+            return QUERY_BAD;
+      }
+      *n_upd_p = count;
+      return (count > 0) ? QUERY_UPDATE : QUERY_BAD;
+   }
+   if (strcmp(tok, "path") == 0 || strcmp(tok, "onpath") == 0) {
+      *upd_p = upd = malloc(sizeof(edge_t));
+      *n_upd_p = 1;
+      upd->u = -1;
+      if (strcmp(tok, "onpath") == 0) {
+         if ((tok = strtok(NULL, " \t\r\n")) == NULL) return QUERY_BAD;
+         upd->u = strtol(tok, &end, 10);
+         if (*end != '\0' || upd->u < 0 || upd->u >= n) return QUERY_BAD;
+      }
+      if ((tok = strtok(NULL, " \t\r\n")) == NULL) return QUERY_BAD;
+      upd->v = strtol(tok, &end, 10);
+      if (*end != '\0' || upd->v < 0 || upd->v >= n 
+            || strtok(NULL, " \t\r\n") != NULL)
+         return QUERY_BAD;
+      return QUERY_PATH;
+   }
+   query->src = strtol(tok, &end, 10);
+   if (*end != '\0' || query->src < 0 || query->src >= n) return QUERY_BAD;
+
+   while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+      if ((arg = strtok(NULL, " \t\r\n")) == NULL) return QUERY_BAD;
+      if (strcmp(tok, "-t") == 0 && query->targets == NULL) {
+         query->targets = Parse_targets(arg, &query->n_targets);
+         if (query->targets == NULL 
+               || query->targets[query->n_targets-1] >= n) 
+            return QUERY_BAD;
+      } else if (strcmp(tok, "-D") == 0) {
+         query->delta = strtod(arg, &end);
+         if (*end != '\0' || query->delta < 0) return QUERY_BAD;
+      } else if (strcmp(tok, "-R") == 0) {
+         radius = strtod(arg, &end);
+         if (*end != '\0' || radius < 0) return QUERY_BAD;
+         query->radius = (radius < INFINITY) ? radius : INFINITY;
+      } else if (strcmp(tok, "-E") == 0) {
+         query->eps = strtod(arg, &end);
+         if (*end != '\0' || query->eps < 0) return QUERY_BAD;
+      } else if (strcmp(tok, "-o") == 0) {
+         query->out_file = arg;
+      } else if (strcmp(tok, "-x") == 0) {
+         query->tree_file = arg;
+      } else {
+         return QUERY_BAD;
+      }
+   }
+
+   /* The same combinations Get_args rejects */
+   if ((query->radius < INFINITY || query->eps > 0) && (query->pipelined 
+            || query->fused || query->device))
+      return QUERY_BAD;
+   if (query->eps > 0 && query->delta > 0) return QUERY_BAD;
+   if (query->tree_file != NULL && query->targets != NULL) return QUERY_BAD;
+
+   return QUERY_RUN;
+}  /* Parse_query */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Serve_queries
+ * Purpose:     Solve the queries in opts->query_file one at a time on
+ *              the graph that's already loaded, and apply the updates
+ *              in it.  See notes 18 and 19.
+ * In args:     loc_mat:  the block column in dense mode, or NULL
+ *              loc_g:  the CSR block in sparse mode, or NULL
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              opts:  the command line options
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * Scratch:     loc_dist, loc_pred
+ */
+void Serve_queries(weight_t loc_mat[], csr_t* loc_g, dist_t loc_dist[], 
+      int loc_pred[], int n, part_t* part, opts_t* opts, int my_rank, 
+      MPI_Comm comm) {
+   char line[MAX_STRING];
+   FILE* fp = NULL;
+   int len, local_ok = 1, status = QUERY_SKIP, n_upd;
+   int tree_src = -1;   /* source of the tree in loc_pred, or -1 */
+   int path_src = -1;   /* source of the tree for path queries, or -1 */
+   int indexed = 0;     /* whether tree is the index of that tree */
+   tree_t tree;
+   edge_t* upd;
+   opts_t query;
+   double t0;
+
+   if (my_rank == 0 && (fp = fopen(opts->query_file, "r")) == NULL)
+      local_ok = 0;
+   Check_for_error(local_ok, "Can't open the query file", comm);
+
+   while (status != QUERY_QUIT) {
+      /* Process 0 reads the next line and broadcasts it */
+      if (my_rank == 0)
+         len = (fgets(line, MAX_STRING, fp) != NULL) ? strlen(line) + 1 : 0;
+      MPI_Bcast(&len, 1, MPI_INT, 0, comm);
+      COUNT_COLL(sizeof(int));
+      if (len == 0) break;
+      MPI_Bcast(line, len, MPI_CHAR, 0, comm);
+      COUNT_COLL(len);
+
+      query = *opts;
+      status = Parse_query(line, &query, n, &upd, &n_upd);
+      if (status == QUERY_BAD && my_rank == 0) {
+         fprintf(stderr, "Bad query.  Expected <src> [-t <targets>] "
+               "[-D <delta>] [-R <radius>] [-E <eps>] [-o <results>] "
+               "[-x <tree>], update <u> <v> <w> ..., path <v> or "
+               "onpath <u> <v>\n");
+         fflush(stderr);
+      } else if (status == QUERY_UPDATE) {
+         if (!Update_sssp(loc_mat, loc_g, upd, n_upd, loc_dist, loc_pred, 
+                  n, part, tree_src, my_rank, comm)) {
+            if (my_rank == 0) {
+               fprintf(stderr, "Bad update.  In sparse mode only the "
+                     "weights of existing edges can change\n");
+               fflush(stderr);
+            }
+         } else {
+            /* Only a repaired tree can still be queried */
+            if (indexed) Free_tree(&tree);
+            indexed = 0;
+            path_src = tree_src;
+            if (tree_src >= 0) {
+               query.src = tree_src;
+               TIC(t0);
+               Output_results(loc_dist, loc_pred, n, part, &query, my_rank,
+                     comm);
+               if (my_rank == 0) fflush(stdout);
+               TOC(t0, T_OUTPUT);
+            }
+         }
+
+         /* Dense updates always succeed */
+         if (opts->device) 
+            Update_device(loc_mat, upd, n_upd, part->counts[my_rank], 
+                  part->first[my_rank]);
+      } else if (status == QUERY_RUN) {
+         Solve(loc_mat, loc_g, NULL, loc_dist, loc_pred, n, part, &query, 
+               my_rank, comm);
+         tree_src = (query.targets == NULL && query.radius >= INFINITY
+               && query.eps == 0) ? query.src : -1;
+         path_src = (query.targets == NULL) ? query.src : -1;
+         if (indexed) Free_tree(&tree);
+         indexed = 0;
+         TIC(t0);
+         Output_results(loc_dist, loc_pred, n, part, &query, my_rank, comm);
+         if (my_rank == 0) fflush(stdout);
+         TOC(t0, T_OUTPUT);
+      } else if (status == QUERY_PATH && path_src < 0) {
+         if (my_rank == 0) {
+            fprintf(stderr, "No shortest-path tree.  Solve a query without "
+                  "-t first\n");
+            fflush(stderr);
+         }
+      } else if (status == QUERY_PATH) {
+         TIC(t0);
+         if (!indexed)
+            Index_tree(loc_dist, loc_pred, n, part, path_src, &tree, 
+                  my_rank, comm);
+         indexed = 1;
+         if (my_rank == 0) {
+            if (upd->u < 0)
+               Print_tree_path(&tree, upd->v);
+            else
+               printf("%d %s on the path %d->%d\n", upd->u, 
+                     On_path(&tree, upd->u, upd->v) ? "is" : "isn't", 
+                     path_src, upd->v);
+            fflush(stdout);
+         }
+         TOC(t0, T_OUTPUT);
+      }
+      free(query.targets);
+      free(upd);
+   }
+
+   if (indexed) Free_tree(&tree);
+   if (my_rank == 0) fclose(fp);
+}  /* Serve_queries */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Find_edge
+ * Purpose:     Find the stored edge u->v in a CSR block
+ * In args:     loc_g:  the CSR block
+ *              u:  a global vertex
+ *              v:  a local vertex
+ * Ret val:     The index e of the edge in cols and wts, or -1 if it
+ *              isn't stored
+ */
+int Find_edge(csr_t* loc_g, int u, int v) {
+   int r = Find_row(loc_g, u), e;
+
+   if (r < 0) return -1;
+   for (e = loc_g->row_ptr[r]; e < loc_g->row_ptr[r+1]; e++)
+      if (loc_g->cols[e] == v) return e;
+   return -1;
+}  /* Find_edge */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Update_sssp
+ * Purpose:     Change the weights of a batch of edges and repair the
+ *              shortest paths from src.  See note 19.
+ * In args:     n_upd:  the number of edges in upd
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              src:  the source of loc_dist and loc_pred, or -1 to 
+ *                 only change the weights
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * In/out args: upd:  the edges and their new weights, the same on 
+ *                 every process.  A weight of NO_EDGE removes an edge
+ *                 in dense mode.  Only the last change of an edge 
+ *                 counts.  On return upd is sorted by edge and the 
+ *                 earlier changes are dropped from it.
+ *              loc_mat:  the block column in dense mode, or NULL
+ *              loc_g:  the CSR block in sparse mode, or NULL
+ *              loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors from src
+ * Ret val:     1, or 0 if an edge of upd isn't stored in sparse mode.
+ *              Then nothing is changed.
+ *
+ * Note:        A vertex whose tree edge got heavier is marked with
+ *              pred[v] = -1.  After an MPI_Allgatherv of pred every
+ *              process finds its vertices below a marked one and resets
+ *              them.  After an MPI_Allgatherv of the distances each
+ *              reset vertex takes its best edge from the kept vertices,
+ *              and the head of each lighter edge takes dist[u] + w if
+ *              that's shorter.  Dijkstra then runs from the lowered
+ *              vertices, and a relaxation can lower a settled vertex,
+ *              which goes back into the heap.  So there's one reduction
+ *              per vertex whose distance changes, but the two gathers
+ *              move all n predecessors and distances, however small the
+ *              update.
+ */
+int Update_sssp(weight_t loc_mat[], csr_t* loc_g, edge_t upd[], int n_upd,
+      dist_t loc_dist[], int loc_pred[], int n, part_t* part, int src, 
+      int my_rank, MPI_Comm comm) {
+   int loc_n = part->counts[my_rank], my_first = part->first[my_rank];
+   int i, e, r, u, v, w, top, local_ok = 1, ok, loc_roots = 0, roots;
+   int *pred, *stack, gen;
+   edge_t* tmp;
+   char* state = NULL;   /* 0 not found, 1 kept, 2 reset */
+   dist_t *dist, new_dist;
+   weight_t *wt, old_w;
+   pair_t my_min, glbl_min;
+   heap_t* heap = &work.heap;
+   double t0;
+
+   /* Only the last change of an edge counts, so its tree edge is */
+   /* compared with the final weight and its head relaxed with it. */
+   /* Sort_edges is stable, so that's the last edge of each run.   */
+   tmp = malloc(n_upd*sizeof(edge_t));
+   Sort_edges(upd, tmp, n_upd, n);
+   free(tmp);
+   for (i = 0, r = 0; i < n_upd; i++)
+      if (i == n_upd - 1 || upd[i+1].u != upd[i].u 
+            || upd[i+1].v != upd[i].v)
+         upd[r++] = upd[i];
+   n_upd = r;
+
+   /* In sparse mode only the weights of stored edges can change */
+   if (loc_g != NULL)
+      for (i = 0; i < n_upd; i++)
+         if (OWNS(my_first, loc_n, upd[i].v) && (upd[i].w >= NO_EDGE
+                  || Find_edge(loc_g, upd[i].u, upd[i].v - my_first) < 0))
+            local_ok = 0;
+   MPI_Allreduce(&local_ok, &ok, 1, MPI_INT, MPI_MIN, comm);
+   COUNT_COLL(sizeof(int));
+   if (!ok) return 0;
+
+   /* Change the weights, and mark the vertices whose tree edges */
+   /* got heavier                                                 */
+   for (i = 0; i < n_upd; i++) {
+      if (!OWNS(my_first, loc_n, upd[i].v)) continue;
+      u = upd[i].u;
+      v = upd[i].v - my_first;
+      if (loc_g != NULL)
+         wt = &loc_g->wts[Find_edge(loc_g, u, v)];
+      else
+         wt = &loc_mat[(size_t) u*loc_n + v];
+      old_w = *wt;
+      *wt = upd[i].w;
+      if (src >= 0 && upd[i].w > old_w && loc_pred[v] == u 
+            && upd[i].v != src && loc_dist[v] < INFINITY) {
+         loc_pred[v] = -1;
+         loc_roots++;
+      }
+   }
+   if (src < 0) return 1;
+
+   /* Reset the vertices below the marked ones */
+   MPI_Allreduce(&loc_roots, &roots, 1, MPI_INT, MPI_SUM, comm);
+   COUNT_COLL(sizeof(int));
+   if (roots > 0) {
+      pred = malloc(n*sizeof(int));
+      stack = malloc(n*sizeof(int));
+      state = calloc(n, 1);
+      MPI_Allgatherv(loc_pred, loc_n, MPI_INT, pred, part->counts, 
+            part->first, MPI_INT, comm);
+      COUNT_COLL(n*sizeof(int));
+      state[src] = 1;
+      for (v = my_first; v < my_first + loc_n; v++) {
+         top = 0;
+         for (w = v; state[w] == 0 && pred[w] >= 0; w = pred[w])
+            stack[top++] = w;
+         if (state[w] == 0) state[w] = 2;
+         while (top > 0) 
+            state[stack[--top]] = state[w];
+      }
+      for (v = 0; v < loc_n; v++)
+         if (state[v + my_first] == 2) {
+            loc_dist[v] = INFINITY;
+            loc_pred[v] = src;
+         }
+      free(pred);
+      free(stack);
+   }
+
+   /* Every process needs the distances of the sources of its edges */
+   dist = malloc(n*sizeof(dist_t));
+   MPI_Allgatherv(loc_dist, loc_n, DIST_MPI, dist, part->counts, 
+         part->first, DIST_MPI, comm);
+   COUNT_COLL(n*sizeof(dist_t));
+   Heap_clear(heap, loc_dist);
+
+   /* Reset vertices take their best edge from the vertices that */
+   /* were kept                                                   */
+   if (roots > 0 && loc_g != NULL) {
+      for (r = 0; r < loc_g->loc_rows; r++) {
+         u = loc_g->rows[r];
+         if (dist[u] >= INFINITY) continue;
+         for (e = loc_g->row_ptr[r]; e < loc_g->row_ptr[r+1]; e++) {
+            v = loc_g->cols[e];
+            new_dist = DIST_ADD(dist[u], loc_g->wts[e]);
+            if (state[v + my_first] == 2 && new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+            }
+         }
+      }
+   } else if (roots > 0) {
+      for (v = 0; v < loc_n; v++) {
+         if (state[v + my_first] != 2) continue;
+         for (u = 0; u < n; u++) {
+            old_w = loc_mat[(size_t) u*loc_n + v];
+            new_dist = DIST_ADD(dist[u], old_w);
+            if (dist[u] < INFINITY && old_w < NO_EDGE 
+                  && new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+            }
+         }
+      }
+   }
+   for (v = 0; v < loc_n; v++)
+      if (state != NULL && state[v + my_first] == 2 
+            && loc_dist[v] < INFINITY)
+         Heap_update(heap, v);
+
+   /* The heads of the lighter edges */
+   for (i = 0; i < n_upd; i++) {
+      u = upd[i].u;
+      v = upd[i].v - my_first;
+      if (!OWNS(my_first, loc_n, upd[i].v) || upd[i].w >= NO_EDGE
+            || dist[u] >= INFINITY) 
+         continue;
+      new_dist = DIST_ADD(dist[u], upd[i].w);
+      if (new_dist < loc_dist[v]) {
+         loc_dist[v] = new_dist;
+         loc_pred[v] = u;
+         Heap_update(heap, v);
+      }
+   }
+   free(dist);
+   free(state);
+
+   /* Dijkstra from the lowered vertices.  Nothing is stamped with */
+   /* a new generation, so Relax_sparse can lower any vertex.       */
+   gen = Next_gen();
+   for (;;) {
+      TIC(t0);
+      if (heap->size > 0) {
+         my_min.dist = loc_dist[heap->verts[0]];
+         my_min.v = heap->verts[0] + my_first;
+      } else {
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
+      }
+      TOC(t0, T_MIN);
+
+      TIC(t0);
+      Allreduce_minloc(&my_min, &glbl_min, 1, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+      if (glbl_min.dist >= INFINITY) break;
+
+      u = glbl_min.v;
+      if (OWNS(my_first, loc_n, u)) {
+         Heap_pop(heap);
+         stats.settled++;
+      }
+
+      TIC(t0);
+      if (loc_g != NULL) {
+         Relax_sparse(loc_g, u, glbl_min.dist, loc_dist, loc_pred, 
+               work.stamp, gen, heap);
+      } else {
+         wt = &loc_mat[(size_t) u*loc_n];
+         for (v = 0; v < loc_n; v++) {
+            new_dist = DIST_ADD(glbl_min.dist, wt[v]);
+            if (wt[v] < NO_EDGE && new_dist < loc_dist[v]) {
+               loc_dist[v] = new_dist;
+               loc_pred[v] = u;
+               Heap_update(heap, v);
+            }
+         }
+      }
+      TOC(t0, T_RELAX);
+   }
+
+   return 1;
+}  /* Update_sssp */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Build_grid
+ * Purpose:     Arrange the processes in a pr x pc grid and split the
+ *              matrix into 2D blocks.  See note 20.
+ * In args:     n:  the number of vertices
+ *              p:  the number of processes
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * Out args:    grid:  the grid.  Free it with Free_grid.
+ *              part:  the vertices whose distances each process 
+ *                 contributes to the output:  column block q on 
+ *                 process q < pc, and none on the others.  Free it 
+ *                 with Free_part.
+ *
+ * Note:        pr is the largest divisor of p with pr*pr <= p, and
+ *              process (I, J) is rank I*pc + J.  If p is prime the grid
+ *              is 1 x p, the block-column layout.
+ */
+void Build_grid(int n, int p, int my_rank, MPI_Comm comm, grid_t* grid,
+      part_t* part) {
+   int q;
+
+   for (grid->pr = 1, q = 2; q*q <= p; q++)
+      if (p % q == 0) grid->pr = q;
+   grid->pc = p/grid->pr;
+   grid->my_row = my_rank/grid->pc;
+   grid->my_col = my_rank % grid->pc;
+   Build_part(n, grid->pr, &grid->rows);
+   Build_part(n, grid->pc, &grid->cols);
+   MPI_Comm_split(comm, grid->my_row, grid->my_col, &grid->row_comm);
+   MPI_Comm_split(comm, grid->my_col, grid->my_row, &grid->col_comm);
+
+   part->p = p;
+   part->first = malloc((p + 1)*sizeof(int));
+   part->counts = malloc(p*sizeof(int));
+   for (q = 0; q <= p; q++)
+      part->first[q] = (q < grid->pc) ? grid->cols.first[q] : n;
+   for (q = 0; q < p; q++)
+      part->counts[q] = part->first[q+1] - part->first[q];
+}  /* Build_grid */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_grid
+ * Purpose:     Free the communicators and blocks built by Build_grid
+ */
+void Free_grid(grid_t* grid) {
+   Free_part(&grid->rows);
+   Free_part(&grid->cols);
+   MPI_Comm_free(&grid->row_comm);
+   MPI_Comm_free(&grid->col_comm);
+}  /* Free_grid */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Read_matrix_2d
+ * Purpose:     Read in an nxn matrix of weights on process 0 and give
+ *              each process its 2D block.  See note 20.
+ * In args:     n:  the number of rows in the matrix
+ *              grid:  the process grid
+ *              my_rank:  the caller's rank
+ * Out arg:     loc_mat:  the calling process' block (needs to be 
+ *                 allocated by the caller)
+ */
+void Read_matrix_2d(weight_t loc_mat[], int n, grid_t* grid, int my_rank) {
+   weight_t *mat = NULL, *blk_row = NULL;
+   int *row_counts = NULL, *row_displs = NULL, i, j, q;
+   int loc_rows = grid->rows.counts[grid->my_row];
+   int loc_n = grid->cols.counts[grid->my_col];
+   MPI_Datatype blk_col_mpi_t, loc_col_mpi_t;
+   double t0;
+
+   TIC(t0);
+   if (my_rank == 0) {
+      mat = malloc((size_t) n*n*sizeof(weight_t));
+      for (i = 0; i < n; i++)
+         for (j = 0; j < n; j++)
+            scanf("%" WEIGHT_SCN, &mat[(size_t) i*n + j]);
+   }
+   TOC(t0, T_PARSE);
+
+   /* Block rows are contiguous:  send them down grid column 0 */
+   TIC(t0);
+   if (grid->my_col == 0) {
+      if (my_rank == 0) {
+         row_counts = malloc(grid->pr*sizeof(int));
+         row_displs = malloc(grid->pr*sizeof(int));
+         for (q = 0; q < grid->pr; q++) {
+            row_counts[q] = n*grid->rows.counts[q];
+            row_displs[q] = n*grid->rows.first[q];
+         }
+      }
+      blk_row = malloc((size_t) n*loc_rows*sizeof(weight_t));
+      MPI_Scatterv(mat, row_counts, row_displs, WEIGHT_MPI, blk_row, 
+            n*loc_rows, WEIGHT_MPI, 0, grid->col_comm);
+      COUNT_COLL((long long) n*loc_rows*sizeof(weight_t));
+      free(row_counts);
+      free(row_displs);
+   }
+
+   /* Then the block columns of each block row across its grid row */
+   blk_col_mpi_t = Build_loc_col_type(loc_rows, n);
+   loc_col_mpi_t = Build_loc_col_type(loc_rows, loc_n);
+   MPI_Scatterv(blk_row, grid->cols.counts, grid->cols.first, 
+         blk_col_mpi_t, loc_mat, loc_n, loc_col_mpi_t, 0, grid->row_comm);
+   COUNT_COLL((long long) loc_rows*loc_n*sizeof(weight_t));
+   MPI_Type_free(&blk_col_mpi_t);
+   MPI_Type_free(&loc_col_mpi_t);
+   TOC(t0, T_SCATTER);
+
+   free(blk_row);
+   if (my_rank == 0) free(mat);
+}  /* Read_matrix_2d */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Load_block
+ * Purpose:   Copy a 2D block out of a mapped LAYOUT_DENSE graph file
+ * In args:   map:  the mapping returned by Map_graph
+ *            n:  the number of rows in the matrix
+ *            first_row, loc_rows:  the rows of the block
+ *            first_col, loc_n:  the columns of the block
+ * Out arg:   loc_mat:  the block, stored by rows
+ */
+void Load_block(void* map, weight_t loc_mat[], int n, int first_row, 
+      int loc_rows, int first_col, int loc_n) {
+   const weight_t* mat = (const weight_t*) ((char*) map 
+         + sizeof(graph_hdr_t));
+   size_t i;
+
+   for (i = 0; i < loc_rows; i++)
+      memcpy(&loc_mat[i*loc_n], &mat[(first_row + i)*n + first_col],
+            loc_n*sizeof(weight_t));
+}  /* Load_block */
+
+
+/*---------------------------------------------------------------------
+ * Function:  Read_block_all
+ * Purpose:   Read each process' 2D block of a LAYOUT_DENSE graph file
+ *            with one collective read, as Read_dense_all does for a 
+ *            block column
+ * In args:   fh:  the file opened by Open_graph
+ *            n:  the number of rows in the matrix
+ *            first_row, loc_rows:  the rows of the block
+ *            first_col, loc_n:  the columns of the block
+ * Out arg:   loc_mat:  the block, stored by rows
+ */
+void Read_block_all(MPI_File fh, weight_t loc_mat[], int n, int first_row, 
+      int loc_rows, int first_col, int loc_n) {
+   MPI_Offset disp = sizeof(graph_hdr_t) 
+      + ((MPI_Offset) first_row*n + first_col)*sizeof(weight_t);
+   MPI_Datatype file_mpi_t;
+
+   MPI_Type_vector(loc_rows, loc_n, n, WEIGHT_MPI, &file_mpi_t);
+   MPI_Type_commit(&file_mpi_t);
+   MPI_File_set_view(fh, disp, WEIGHT_MPI, file_mpi_t, "native", 
+         MPI_INFO_NULL);
+   MPI_File_read_all(fh, loc_mat, loc_rows*loc_n, WEIGHT_MPI, 
+         MPI_STATUS_IGNORE);
+   MPI_Type_free(&file_mpi_t);
+}  /* Read_block_all */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_2d
+ * Purpose:     Apply Dijkstra's algorithm to the matrix stored in 2D 
+ *              blocks.  See note 20.
+ * In args:     loc_mat:  the calling process' block
+ *              grid:  the process grid
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              targets:  sorted list of vertices to stop after, or NULL
+ *              n_targets:  the number of targets
+ * Out args:    loc_dist, loc_pred:  the distances and predecessors of
+ *                 the vertices in the process' column block
+ *
+ * Note:        Each step reduces the MINLOC pairs over the grid row,
+ *              and then the grid row holding row u broadcasts its part
+ *              of the row down the grid column, so no collective spans
+ *              all p processes.  Grid row 0 holds every distance once.
+ */
+void Dijkstra_2d(weight_t loc_mat[], dist_t loc_dist[], int loc_pred[], 
+      grid_t* grid, int n, int src, int targets[], int n_targets) {
+   int loc_n = grid->cols.counts[grid->my_col];
+   int my_first = grid->cols.first[grid->my_col];
+   int row_first = grid->rows.first[grid->my_row];
+   int i, loc_u, u, v, root;
+   pair_t my_min, glbl_min;
+   uint32_t* known;
+   weight_t *row, *row_buf;
+   double t0;
+
+   /* Without targets remaining never reaches 0 */
+   int remaining = (targets != NULL) ? n_targets : n;
+
+   known = calloc(KNOWN_WORDS(loc_n), sizeof(uint32_t));
+   row_buf = malloc(loc_n*sizeof(weight_t));
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = INFINITY;
+      loc_pred[v] = src;
+   }
+   if (OWNS(my_first, loc_n, src)) loc_dist[src - my_first] = 0;
+
+   /* The first pass settles src */
+   for (i = 0; i < n && remaining > 0; i++) {
+      TIC(t0);
+      loc_u = Find_min_dist_bits(loc_dist, known, loc_n);
+      if (loc_u < NO_VERTEX) {
+         my_min.dist = loc_dist[loc_u];
+         my_min.v = loc_u + my_first;
+      } else {
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
+      }
+      TOC(t0, T_MIN);
+
+      /* The minimum over the column blocks in my grid row */
+      TIC(t0);
+      MPI_Allreduce(&my_min, &glbl_min, 1, PAIR_MPI, MPI_MINLOC, 
+            grid->row_comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+
+      if (glbl_min.dist >= INFINITY) break;
+      u = glbl_min.v;
+      if (OWNS(my_first, loc_n, u)) {
+         SET_KNOWN(known, u - my_first);
+         stats.settled++;
+      }
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+
+      /* The grid row holding row u sends it down my grid column */
+      TIC(t0);
+      root = Owner(&grid->rows, u);
+      row = (root == grid->my_row) 
+         ? &loc_mat[(size_t) (u - row_first)*loc_n] : row_buf;
+      MPI_Bcast(row, loc_n, WEIGHT_MPI, root, grid->col_comm);
+      COUNT_COLL(loc_n*sizeof(weight_t));
+      TOC(t0, T_COMM);
+
+      TIC(t0);
+      Relax_dense(row, u, glbl_min.dist, loc_dist, loc_pred, known, loc_n);
+      TOC(t0, T_RELAX);
+   }
+
+   free(known);
+   free(row_buf);
+}  /* Dijkstra_2d */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Read_matrix_shared
+ * Purpose:     Read in an nxn matrix of weights on process 0 and send
+ *              each node the block columns of its processes in one 
+ *              message.  See note 21.
+ * In args:     n:  the number of rows in the matrix
+ *              part:  the columns owned by each process
+ *              win:  the shared window holding loc_mat
+ *              node_comm:  the processes on the caller's node, in 
+ *                 rank order
+ *              my_rank:  the caller's rank in comm
+ *              comm:  Communicator consisting of all the processes
+ * Out arg:     win:  every process' loc_mat
+ *
+ * Note:        The parts of the window are contiguous and in rank
+ *              order, so a node's block columns are one array.  Process
+ *              0 sends each node one message of whole columns, and the
+ *              node's first process receives it straight into the
+ *              window.
+ */
+void Read_matrix_shared(int n, part_t* part, MPI_Win win, 
+      MPI_Comm node_comm, int my_rank, MPI_Comm comm) {
+   weight_t *mat = NULL, *base;
+   int node_rank, node_size, n_nodes, disp_unit, i, j, k, q, *members;
+   int *node_sizes = NULL, *node_displs = NULL, *all = NULL, *leaders = NULL;
+   int *blk_lens, *displs;
+   MPI_Aint size, seg_size, *byte_displs;
+   MPI_Datatype blk_col_mpi_t, *col_types, node_mpi_t, send_mpi_t;
+   MPI_Request req, *reqs = NULL;
+   MPI_Comm leader_comm;
+   double t0;
+
+   TIC(t0);
+   if (my_rank == 0) {
+      mat = malloc((size_t) n*n*sizeof(weight_t));
+      for (i = 0; i < n; i++)
+         for (j = 0; j < n; j++)
+            scanf("%" WEIGHT_SCN, &mat[(size_t) i*n + j]);
+   }
+   TOC(t0, T_PARSE);
+
+   TIC(t0);
+   MPI_Comm_rank(node_comm, &node_rank);
+   MPI_Comm_size(node_comm, &node_size);
+   members = malloc(node_size*sizeof(int));
+   MPI_Allgather(&my_rank, 1, MPI_INT, members, 1, MPI_INT, node_comm);
+   COUNT_COLL(sizeof(int));
+   MPI_Comm_split(comm, (node_rank == 0) ? 0 : MPI_UNDEFINED, my_rank, 
+         &leader_comm);
+
+   if (node_rank == 0) {
+      /* Process 0 learns which processes are on each node */
+      MPI_Comm_size(leader_comm, &n_nodes);
+      if (my_rank == 0) {
+         node_sizes = malloc(n_nodes*sizeof(int));
+         node_displs = malloc(n_nodes*sizeof(int));
+         leaders = malloc(n_nodes*sizeof(int));
+         all = malloc(part->p*sizeof(int));
+      }
+      MPI_Gather(&node_size, 1, MPI_INT, node_sizes, 1, MPI_INT, 0, 
+            leader_comm);
+      MPI_Gather(&my_rank, 1, MPI_INT, leaders, 1, MPI_INT, 0, leader_comm);
+      if (my_rank == 0)
+         for (k = 0, node_displs[0] = 0; k < n_nodes - 1; k++)
+            node_displs[k+1] = node_displs[k] + node_sizes[k];
+      MPI_Gatherv(members, node_size, MPI_INT, all, node_sizes, 
+            node_displs, MPI_INT, 0, leader_comm);
+      COUNT_COLL(3*sizeof(int));
+
+      /* The node's parts of the window are contiguous:  receive the */
+      /* columns of each process into its part                       */
+      MPI_Win_shared_query(win, 0, &seg_size, &disp_unit, &base);
+      col_types = malloc(node_size*sizeof(MPI_Datatype));
+      blk_lens = malloc(node_size*sizeof(int));
+      byte_displs = malloc(node_size*sizeof(MPI_Aint));
+      for (i = 0, size = 0; i < node_size; i++) {
+         q = members[i];
+         col_types[i] = Build_loc_col_type(n, part->counts[q]);
+         blk_lens[i] = part->counts[q];
+         byte_displs[i] = size;
+         size += (MPI_Aint) n*part->counts[q]*sizeof(weight_t);
+      }
+      MPI_Type_create_struct(node_size, blk_lens, byte_displs, col_types, 
+            &node_mpi_t);
+      MPI_Type_commit(&node_mpi_t);
+      MPI_Irecv(base, 1, node_mpi_t, 0, 0, comm, &req);
+
+      /* Process 0 sends each node its processes' columns */
+      if (my_rank == 0) {
+         blk_col_mpi_t = Build_blk_col_type(n);
+         reqs = malloc(n_nodes*sizeof(MPI_Request));
+         displs = malloc(part->p*sizeof(int));
+         for (k = 0; k < n_nodes; k++) {
+            for (i = 0; i < node_sizes[k]; i++) {
+               q = all[node_displs[k] + i];
+               displs[i] = part->first[q];
+               blk_lens[i] = part->counts[q];
+            }
+            MPI_Type_indexed(node_sizes[k], blk_lens, displs, 
+                  blk_col_mpi_t, &send_mpi_t);
+            MPI_Type_commit(&send_mpi_t);
+            MPI_Isend(mat, 1, send_mpi_t, leaders[k], 0, comm, &reqs[k]);
+            MPI_Type_free(&send_mpi_t);
+         }
+         MPI_Waitall(n_nodes, reqs, MPI_STATUSES_IGNORE);
+         MPI_Type_free(&blk_col_mpi_t);
+         free(reqs);
+         free(displs);
+         free(node_sizes);
+         free(node_displs);
+         free(leaders);
+         free(all);
+      }
+      MPI_Wait(&req, MPI_STATUS_IGNORE);
+      for (i = 0; i < node_size; i++)
+         MPI_Type_free(&col_types[i]);
+      MPI_Type_free(&node_mpi_t);
+      free(col_types);
+      free(blk_lens);
+      free(byte_displs);
+      MPI_Comm_free(&leader_comm);
+      COUNT_COLL(size);
+   }
+
+   /* The other processes on the node can read their parts now */
+   MPI_Win_fence(0, win);
+   TOC(t0, T_SCATTER);
+
+   free(members);
+   if (my_rank == 0) free(mat);
+}  /* Read_matrix_shared */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Build_hier
+ * Purpose:     Build the communicators for two-level MINLOC 
+ *              reductions on comm.  See note 22.
+ * In arg:      comm:  Communicator consisting of all the processes
+ */
+void Build_hier(MPI_Comm comm) {
+   int my_rank, node_rank;
+
+   MPI_Comm_rank(comm, &my_rank);
+   MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank, MPI_INFO_NULL,
+         &hier.node_comm);
+   MPI_Comm_rank(hier.node_comm, &node_rank);
+   MPI_Comm_split(comm, (node_rank == 0) ? 0 : MPI_UNDEFINED, my_rank, 
+         &hier.leader_comm);
+   hier.comm = comm;
+}  /* Build_hier */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_hier
+ * Purpose:     Free the communicators built by Build_hier
+ */
+void Free_hier(void) {
+   MPI_Comm_free(&hier.node_comm);
+   if (hier.leader_comm != MPI_COMM_NULL) MPI_Comm_free(&hier.leader_comm);
+   hier.comm = MPI_COMM_NULL;
+}  /* Free_hier */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Allreduce_minloc
+ * Purpose:     Find the MINLOC of count pairs over the processes in 
+ *              comm, in two levels if Build_hier was called for comm
+ * In args:     in:  the calling process' pairs
+ *              count:  the number of pairs
+ *              comm:  the communicator
+ * Out arg:     out:  the minima, on every process
+ *
+ * Note:        With -H the pairs are reduced to the first process of
+ *              each node, reduced among those processes, and broadcast
+ *              back inside each node.  MINLOC is associative and breaks
+ *              ties by vertex, so the result is the same as the flat
+ *              reduction's.
+ */
+void Allreduce_minloc(pair_t in[], pair_t out[], int count, MPI_Comm comm) {
+   if (comm != hier.comm) {
+      MPI_Allreduce(in, out, count, PAIR_MPI, MPI_MINLOC, comm);
+      return;
+   }
+
+   MPI_Reduce(in, out, count, PAIR_MPI, MPI_MINLOC, 0, hier.node_comm);
+   if (hier.leader_comm != MPI_COMM_NULL)
+      MPI_Allreduce(MPI_IN_PLACE, out, count, PAIR_MPI, MPI_MINLOC, 
+            hier.leader_comm);
+   MPI_Bcast(out, count, PAIR_MPI, 0, hier.node_comm);
+}  /* Allreduce_minloc */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Arena_init
+ * Purpose:     Map at least size bytes for Arena_alloc.  See note 23.
+ * In arg:      size:  the number of bytes, including the padding 
+ *                 Arena_alloc adds
+ * Out arg:     arena:  the arena
+ * Ret val:     1, or 0 if the memory couldn't be mapped
+ */
+int Arena_init(arena_t* arena, size_t size) {
+   size = ALIGN_UP(size, HUGE_PAGE);
+   arena->map_size = size + HUGE_PAGE;
+   arena->map = mmap(NULL, arena->map_size, PROT_READ | PROT_WRITE, 
+         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (arena->map == MAP_FAILED) return 0;
+   arena->base = (char*) ALIGN_UP((uintptr_t) arena->map, HUGE_PAGE);
+   arena->used = 0;
+#  ifdef MADV_HUGEPAGE
+   madvise(arena->base, size, MADV_HUGEPAGE);
+#  endif
+   return 1;
+}  /* Arena_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Arena_alloc
+ * Purpose:     Take the next size bytes of an arena.  The memory
+ *              starts on a cache line and is zero the first time 
+ *              it's used.
+ * In arg:      size:  the number of bytes
+ * In/out arg:  arena:  an arena with room for them
+ * Ret val:     The memory
+ */
+void* Arena_alloc(arena_t* arena, size_t size) {
+   char* p = arena->base + arena->used;
+
+   arena->used += ALIGN_UP(size, CACHE_LINE);
+   return p;
+}  /* Arena_alloc */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Arena_free
+ * Purpose:     Unmap an arena
+ */
+void Arena_free(arena_t* arena) {
+   munmap(arena->map, arena->map_size);
+}  /* Arena_free */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Build_work
+ * Purpose:     Allocate the solvers' workspace for the loaded graph.
+ *              See note 23.
+ * In args:     n:  the number of vertices
+ *              loc_n:  the number of vertices owned by the calling
+ *                 process
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ *
+ * Note:        The arrays are carved out of one anonymous mapping
+ *              aligned to a 2 MB page and marked MADV_HUGEPAGE, each on
+ *              its own cache line, so batch and service mode don't
+ *              malloc or page-fault per query.
+ */
+void Build_work(int n, int loc_n, int my_rank, MPI_Comm comm) {
+   int v;
+   size_t size;
+
+   size = ALIGN_UP(loc_n*sizeof(dist_t), CACHE_LINE) 
+      + 4*ALIGN_UP(loc_n*sizeof(int), CACHE_LINE)
+      + ALIGN_UP(KNOWN_WORDS(loc_n)*sizeof(uint32_t), CACHE_LINE);
+   if (my_rank == 0)
+      size += ALIGN_UP(n*sizeof(dist_t), CACHE_LINE) 
+         + 2*ALIGN_UP(n*sizeof(int), CACHE_LINE)
+         + ALIGN_UP(n*sizeof(int64_t), CACHE_LINE);
+   Check_for_error(Arena_init(&work.arena, size), 
+         "Can't allocate the solver workspace", comm);
+
+   work.loc_n = loc_n;
+   work.loc_dist = Arena_alloc(&work.arena, loc_n*sizeof(dist_t));
+   work.loc_pred = Arena_alloc(&work.arena, loc_n*sizeof(int));
+   work.known = Arena_alloc(&work.arena, 
+         KNOWN_WORDS(loc_n)*sizeof(uint32_t));
+   work.stamp = Arena_alloc(&work.arena, loc_n*sizeof(int));
+   work.gen = 0;
+   work.heap.size = 0;
+   work.heap.keys = work.loc_dist;
+   work.heap.verts = Arena_alloc(&work.arena, loc_n*sizeof(int));
+   work.heap.pos = Arena_alloc(&work.arena, loc_n*sizeof(int));
+   for (v = 0; v < loc_n; v++)
+      work.heap.pos[v] = -1;
+
+   work.dist = NULL;
+   work.pred = work.stack = NULL;
+   work.len = NULL;
+   if (my_rank == 0) {
+      work.dist = Arena_alloc(&work.arena, n*sizeof(dist_t));
+      work.pred = Arena_alloc(&work.arena, n*sizeof(int));
+      work.len = Arena_alloc(&work.arena, n*sizeof(int64_t));
+      work.stack = Arena_alloc(&work.arena, n*sizeof(int));
+   }
+}  /* Build_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_work
+ * Purpose:     Free the workspace allocated by Build_work
+ */
+void Free_work(void) {
+   Arena_free(&work.arena);
+}  /* Free_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Next_gen
+ * Purpose:     Start a new generation of work.stamp, so that no 
+ *              vertex is known.  See note 23.
+ * Ret val:     The new generation
+ */
+int Next_gen(void) {
+   if (work.gen == INT_MAX) {
+      memset(work.stamp, 0, work.loc_n*sizeof(int));
+      work.gen = 0;
+   }
+   return ++work.gen;
+}  /* Next_gen */
+
+
+#ifdef SETTLED_BIT
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_fused
+ * Purpose:     Apply Dijkstra's algorithm to the dense block columns,
+ *              marking settled vertices in loc_dist and relaxing and
+ *              finding the local minimum in one pass.  See note 24.
+ * In args:     mat:  the calling process' block column
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances
+ *              loc_pred:  subarray of predecessors
+ *
+ * Note:        A settled entry of loc_dist has its sign bit set
+ *              (SETTLE).  As a signed value it's negative, so
+ *              relaxation never lowers it, and as an unsigned value
+ *              it's above INFINITY, so the minimum search skips it.
+ *              The bits are cleared at the end.
+ */
+void Dijkstra_fused(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+      int loc_n, int my_first, int n, int src, int targets[], 
+      int n_targets, MPI_Comm comm) {
+   int i, loc_u, u, v;
+   dist_t u_dist;
+   pair_t my_min, glbl_min;
+   int remaining = (targets != NULL) ? n_targets : n;
+   double t0;
+
+   /* The first pass relaxes the edges out of src */
+#  ifdef _OPENMP
+#  pragma omp parallel for if (loc_n >= OMP_MIN_N)
+#  endif
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = INFINITY;
+      loc_pred[v] = src;
+   }
+   if (OWNS(my_first, loc_n, src)) {
+      loc_dist[src - my_first] = SETTLE(0);
+      stats.settled++;
+   }
+   if (Is_target(src, targets, n_targets)) remaining--;
+   u = src;
+   u_dist = 0;
+
+   for (i = 1; i < n && remaining > 0; i++) {
+      TIC(t0);
+      loc_u = Relax_min_fused(&mat[(size_t) u*loc_n], u, u_dist, loc_dist, 
+            loc_pred, loc_n);
+      TOC(t0, T_RELAX);
+
+      if (loc_u < NO_VERTEX) {
+         my_min.dist = loc_dist[loc_u];
+         my_min.v = loc_u + my_first;
+      } else {
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
+      }
+
+      TIC(t0);
+      Allreduce_minloc(&my_min, &glbl_min, 1, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+
+      /* The rest of the vertices can't be reached */
+      if (glbl_min.dist >= INFINITY) break;
+      u = glbl_min.v;
+      u_dist = glbl_min.dist;
+
+      if (OWNS(my_first, loc_n, u)) {
+         loc_dist[u - my_first] = SETTLE(u_dist);
+         stats.settled++;
+      }
+
+      /* Stops once all of the targets are known */
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+   } /* for i */
+
+#  ifdef _OPENMP
+#  pragma omp parallel for if (loc_n >= OMP_MIN_N)
+#  endif
+   for (v = 0; v < loc_n; v++)
+      loc_dist[v] = UNSETTLE(loc_dist[v]);
+}  /* Dijkstra_fused */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_min_fused
+ * Purpose:     Relax the edges out of the newly settled vertex u into
+ *              the calling process' block column, and find the 
+ *              unsettled vertex with minimum distance in the same 
+ *              pass.  Settled entries of loc_dist are marked with
+ *              SETTLE (note 24).
+ * In args:     row:  row u of the block column
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path src->u
+ *              loc_n:  the number of vertices in the block
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ * Ret val:     The local vertex with minimum distance after the 
+ *              relaxation, or NO_VERTEX if every vertex is settled 
+ *              or unreachable.  Ties go to the smaller vertex.
+ */
+int Relax_min_fused(weight_t row[], int u, dist_t u_dist, 
+      dist_t loc_dist[], int loc_pred[], int loc_n) {
+   int loc_u = NO_VERTEX;
+   dist_t loc_min_dist = INFINITY;
+
+#  ifdef _OPENMP
+#  pragma omp parallel if (loc_n >= OMP_MIN_N)
+#  endif
+   {
+      int first, last, my_u;
+      dist_t my_min_dist;
+
+      Thread_range(loc_n, &first, &last);
+      Relax_min_range(row, u, u_dist, loc_dist, loc_pred, first, last, 
+            &my_u, &my_min_dist);
+
+#     ifdef _OPENMP
+#     pragma omp critical
+#     endif
+      if (my_min_dist < loc_min_dist 
+            || (my_min_dist == loc_min_dist && my_u < loc_u)) {
+         loc_u = my_u;
+         loc_min_dist = my_min_dist;
+      }
+   }
+
+   return loc_u;
+}  /* Relax_min_fused */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Relax_min_range
+ * Purpose:     Relax the edges out of u into first, ..., last-1 and
+ *              find the unsettled vertex with minimum distance among
+ *              them
+ * In args:     row:  row u of the block column
+ *              u:  the global vertex that was just settled
+ *              u_dist:  the length of the shortest path to u
+ *              first:  the first vertex to relax
+ *              last:  one past the last vertex to relax
+ * In/out:      loc_dist, loc_pred:  local distances and predecessors
+ * Out args:    u_p:  the vertex with minimum distance, or NO_VERTEX
+ *              min_p:  its distance, or INFINITY
+ */
+void Relax_min_range(weight_t row[], int u, dist_t u_dist, 
+      dist_t loc_dist[], int loc_pred[], int first, int last, int* u_p, 
+      dist_t* min_p) {
+   int v = first, my_u = NO_VERTEX;
+   dist_t d, new_dist, min_dist = INFINITY;
+
+#  if defined(USE_AVX512)
+   __m512i u_dists = _mm512_set1_epi32(u_dist);
+   __m512i us = _mm512_set1_epi32(u);
+   __m512i best = _mm512_set1_epi32(INFINITY);
+   __m512i best_v = _mm512_set1_epi32(NO_VERTEX);
+   __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(first),
+         _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 
+                           8, 9, 10, 11, 12, 13, 14, 15));
+   __m512i dists, new_dists, w;
+   __mmask16 lt;
+#  ifdef NARROW_WEIGHTS
+   __m512i no_edges = _mm512_set1_epi32(NO_EDGE);
+   __m512i infs = _mm512_set1_epi32(INFINITY);
+#  endif
+
+   for (; v + 16 <= last; v += 16) {
+      dists = _mm512_loadu_si512(&loc_dist[v]);
+      w = LOAD_WTS_16(&row[v]);
+#     ifdef NARROW_WEIGHTS
+      new_dists = _mm512_min_epu32(_mm512_add_epi32(u_dists, w), infs);
+      lt = _mm512_mask_cmplt_epi32_mask(
+            _mm512_cmpneq_epi32_mask(w, no_edges), new_dists, dists);
+#     else
+      new_dists = _mm512_add_epi32(u_dists, w);
+      lt = _mm512_cmplt_epi32_mask(new_dists, dists);
+#     endif
+      _mm512_mask_storeu_epi32(&loc_dist[v], lt, new_dists);
+      _mm512_mask_storeu_epi32(&loc_pred[v], lt, us);
+      dists = _mm512_mask_mov_epi32(dists, lt, new_dists);
+
+      /* Settled lanes are larger than INFINITY as unsigned */
+      lt = _mm512_cmplt_epu32_mask(dists, best);
+      best = _mm512_mask_mov_epi32(best, lt, dists);
+      best_v = _mm512_mask_mov_epi32(best_v, lt, idx);
+      idx = _mm512_add_epi32(idx, _mm512_set1_epi32(16));
+   }
+   min_dist = _mm512_reduce_min_epi32(best);
+   if (min_dist < INFINITY)
+      my_u = _mm512_mask_reduce_min_epi32(
+            _mm512_cmpeq_epi32_mask(best, _mm512_set1_epi32(min_dist)), 
+            best_v);
+#  elif defined(USE_AVX2)
+   __m256i u_dists = _mm256_set1_epi32(u_dist);
+   __m256i us = _mm256_set1_epi32(u);
+   __m256i signs = _mm256_set1_epi32(SETTLED_BIT);
+   __m256i best = _mm256_set1_epi32(INFINITY ^ SETTLED_BIT);
+   __m256i best_v = _mm256_set1_epi32(NO_VERTEX);
+   __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(first),
+         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+   __m256i dists, new_dists, w, lt, flipped;
+   int lane, lane_min[8], lane_v[8];
+#  ifdef NARROW_WEIGHTS
+   __m256i no_edges = _mm256_set1_epi32(NO_EDGE);
+   __m256i infs = _mm256_set1_epi32(INFINITY);
+#  endif
+
+   for (; v + 8 <= last; v += 8) {
+      dists = _mm256_loadu_si256((__m256i*) &loc_dist[v]);
+      w = LOAD_WTS_8(&row[v]);
+#     ifdef NARROW_WEIGHTS
+      new_dists = _mm256_min_epu32(_mm256_add_epi32(u_dists, w), infs);
+      lt = _mm256_andnot_si256(_mm256_cmpeq_epi32(w, no_edges),
+            _mm256_cmpgt_epi32(dists, new_dists));
+#     else
+      new_dists = _mm256_add_epi32(u_dists, w);
+      lt = _mm256_cmpgt_epi32(dists, new_dists);
+#     endif
+      dists = _mm256_blendv_epi8(dists, new_dists, lt);
+      _mm256_storeu_si256((__m256i*) &loc_dist[v], dists);
+      _mm256_storeu_si256((__m256i*) &loc_pred[v], 
+            _mm256_blendv_epi8(_mm256_loadu_si256((__m256i*) &loc_pred[v]),
+               us, lt));
+
+      /* An unsigned compare is a signed compare with the sign bits */
+      /* flipped.  best is kept flipped.                             */
+      flipped = _mm256_xor_si256(dists, signs);
+      lt = _mm256_cmpgt_epi32(best, flipped);
+      best = _mm256_blendv_epi8(best, flipped, lt);
+      best_v = _mm256_blendv_epi8(best_v, idx, lt);
+      idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+   }
+   _mm256_storeu_si256((__m256i*) lane_min, _mm256_xor_si256(best, signs));
+   _mm256_storeu_si256((__m256i*) lane_v, best_v);
+   for (lane = 0; lane < 8; lane++)
+      if (lane_min[lane] < min_dist 
+            || (lane_min[lane] == min_dist && lane_v[lane] < my_u)) {
+         min_dist = lane_min[lane];
+         my_u = lane_v[lane];
+      }
+   if (min_dist == INFINITY) my_u = NO_VERTEX;
+#  endif
+
+   /* The rest of the range, or all of it without SIMD.  A settled */
+   /* d is negative, so new_dist < d is false.                      */
+   for (; v < last; v++) {
+      d = loc_dist[v];
+      new_dist = DIST_ADD(u_dist, row[v]);
+      if (row[v] < NO_EDGE && new_dist < d) {
+         loc_dist[v] = d = new_dist;
+         loc_pred[v] = u;
+      }
+      if ((udist_t) d < (udist_t) min_dist) {
+         my_u = v;
+         min_dist = d;
+      }
+   }
+
+   *u_p = my_u;
+   *min_p = min_dist;
+}  /* Relax_min_range */
+#endif
+
+
+#ifdef INT_DIST
+/*-------------------------------------------------------------------
+ * Function:    Dijkstra_device
+ * Purpose:     Apply Dijkstra's algorithm to the dense block columns
+ *              on the device.  See note 25.
+ * In args:     mat:  the calling process' block column, already on
+ *                 the device
+ *              loc_n:  size of loc_dist[] and loc_pred[]
+ *              my_first:  the first vertex owned by the process
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              targets:  sorted list of vertices to stop after, or
+ *                 NULL to settle every vertex (note 10)
+ *              n_targets:  the number of targets
+ *              comm:  MPI Communicator
+ * Out args:    loc_dist:  subarray of distances, allocated on the 
+ *                 device
+ *              loc_pred:  subarray of predecessors, allocated on the 
+ *                 device
+ *
+ * Note:        main maps loc_mat to the device once and allocates
+ *              loc_dist and loc_pred there, so they stay resident
+ *              across queries.  Each step is one kernel that settles
+ *              the last vertex chosen, relaxes its row and reduces the
+ *              rest to the smallest KEY(dist, v), so only 8 bytes come
+ *              back for the MINLOC.
+ */
+void Dijkstra_device(weight_t mat[], dist_t loc_dist[], int loc_pred[], 
+      int loc_n, int my_first, int n, int src, int targets[], 
+      int n_targets, MPI_Comm comm) {
+   int i, u, v, settle = -1;
+   dist_t u_dist = 0;
+   uint64_t best;
+   pair_t my_min, glbl_min;
+   int remaining = (targets != NULL) ? n_targets : n;
+   double t0;
+
+   /* src is 0 even if the loop below never runs */
+#  ifdef _OPENMP
+#  pragma omp target teams distribute parallel for
+#  endif
+   for (v = 0; v < loc_n; v++) {
+      loc_dist[v] = (v + my_first == src) ? 0 : INFINITY;
+      loc_pred[v] = src;
+   }
+
+   /* The first step settles src and relaxes its row */
+   u = src;
+   if (OWNS(my_first, loc_n, src)) {
+      settle = src - my_first;
+      stats.settled++;
+   }
+   if (Is_target(src, targets, n_targets)) remaining--;
+
+   for (i = 1; i < n && remaining > 0; i++) {
+      TIC(t0);
+      best = KEY_NONE;
+#     ifdef _OPENMP
+#     pragma omp target teams distribute parallel for \
+         reduction(min: best) map(tofrom: best)
+#     endif
+      for (v = 0; v < loc_n; v++) {
+         weight_t w = mat[(size_t) u*loc_n + v];
+         dist_t d = (v == settle) ? SETTLE(u_dist) : loc_dist[v];
+         dist_t new_dist = DIST_ADD(u_dist, w);
+
+         /* A settled d is negative */
+         if (w < NO_EDGE && new_dist < d) {
+            d = new_dist;
+            loc_pred[v] = u;
+         }
+         loc_dist[v] = d;
+         if (KEY((udist_t) d, v) < best) best = KEY((udist_t) d, v);
+      }
+      TOC(t0, T_RELAX);
+
+      /* Once every local vertex is settled best is a settled key */
+      if ((best >> 32) < INFINITY) {
+         my_min.dist = best >> 32;
+         my_min.v = (uint32_t) best + my_first;
+      } else {
+         my_min.dist = INFINITY;
+         my_min.v = NO_VERTEX;
+      }
+
+      TIC(t0);
+      Allreduce_minloc(&my_min, &glbl_min, 1, comm);
+      COUNT_COLL(sizeof(my_min));
+      TOC(t0, T_COMM);
+
+      /* The rest of the vertices can't be reached */
+      if (glbl_min.dist >= INFINITY) break;
+      u = glbl_min.v;
+      u_dist = glbl_min.dist;
+
+      settle = -1;
+      if (OWNS(my_first, loc_n, u)) {
+         settle = u - my_first;
+         stats.settled++;
+      }
+
+      /* Stops once all of the targets are known */
+      if (Is_target(u, targets, n_targets) && --remaining == 0) break;
+   } /* for i */
+
+   TIC(t0);
+#  ifdef _OPENMP
+#  pragma omp target teams distribute parallel for
+#  endif
+   for (v = 0; v < loc_n; v++)
+      loc_dist[v] = UNSETTLE(loc_dist[v]);
+#  ifdef _OPENMP
+#  pragma omp target update from(loc_dist[0:loc_n], loc_pred[0:loc_n])
+#  endif
+   TOC(t0, T_RELAX);
+}  /* Dijkstra_device */
+#endif
+
+
+/*-------------------------------------------------------------------
+ * Function:    Update_device
+ * Purpose:     Copy the weights changed by an update to the device's
+ *              copy of the block column.  See note 25.
+ * In args:     loc_mat:  the block column, with the new weights
+ *              upd:  the edges that changed
+ *              n_upd:  the number of edges in upd
+ *              loc_n:  the number of columns in loc_mat
+ *              my_first:  the first vertex owned by the process
+ */
+void Update_device(weight_t loc_mat[], edge_t upd[], int n_upd, int loc_n,
+      int my_first) {
+   /* Without OpenMP there's only the host's copy */
+#  ifdef _OPENMP
+   int i;
+   size_t e;
+
+   for (i = 0; i < n_upd; i++) {
+      if (!OWNS(my_first, loc_n, upd[i].v)) continue;
+      e = (size_t) upd[i].u*loc_n + upd[i].v - my_first;
+#     pragma omp target update to(loc_mat[e:1])
+   }
+#  endif
+}  /* Update_device */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Open_ckpt
+ * Purpose:     Collectively open the checkpoint file for -C, and 
+ *              either read the header of the checkpoint in it or
+ *              start an empty one.  See note 28.
+ * In args:     fname:  the name of the file
+ *              steps:  the number of steps between checkpoints
+ *              restart:  whether to resume from the file
+ *              loc_mat:  the calling process' block column
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ *              targets:  sorted list of targets for -t, or NULL
+ *              n_targets:  the number of targets
+ *              loc_n:  the number of vertices owned by the process
+ *              my_first:  the first vertex owned by the process
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ */
+void Open_ckpt(char fname[], long steps, int restart, weight_t loc_mat[],
+      int n, int src, int targets[], int n_targets, int loc_n, 
+      int my_first, int my_rank, MPI_Comm comm) {
+   ckpt_hdr_t* hdr = &ckpt.hdr;
+   MPI_Offset size;
+   int local_ok = 1, found;
+   uint64_t graph_hash = Hash_graph(loc_mat, n, loc_n, my_first, comm);
+   uint64_t target_hash = Hash_targets(targets, n_targets);
+
+   if (MPI_File_open(comm, fname, MPI_MODE_CREATE | MPI_MODE_RDWR,
+            MPI_INFO_NULL, &ckpt.fh) != MPI_SUCCESS) {
+      local_ok = 0;
+      ckpt.fh = MPI_FILE_NULL;
+   }
+   Check_for_error(local_ok, "Can't open the checkpoint file", comm);
+
+   memset(hdr, 0, sizeof(ckpt_hdr_t));
+   if (restart) {
+      MPI_File_get_size(ckpt.fh, &size);
+      if (my_rank == 0 && size >= (MPI_Offset) sizeof(ckpt_hdr_t))
+         MPI_File_read_at(ckpt.fh, 0, hdr, sizeof(ckpt_hdr_t), MPI_BYTE,
+               MPI_STATUS_IGNORE);
+      MPI_Bcast(hdr, sizeof(ckpt_hdr_t), MPI_BYTE, 0, comm);
+      COUNT_COLL(sizeof(ckpt_hdr_t));
+   }
+   found = (memcmp(hdr->magic, CKPT_MAGIC, 4) == 0);
+   Check_for_error(!found || (hdr->version == CKPT_VERSION 
+            && hdr->dist_type == DIST_CODE && hdr->n == n 
+            && hdr->src == src && hdr->graph_hash == graph_hash
+            && hdr->target_hash == target_hash), 
+         "The checkpoint is for another graph, source, targets or weight "
+         "type", comm);
+
+   if (!found) {
+      /* Start over with two empty slots */
+      MPI_File_set_size(ckpt.fh, 0);
+      memcpy(hdr->magic, CKPT_MAGIC, 4);
+      hdr->version = CKPT_VERSION;
+      hdr->dist_type = DIST_CODE;
+      hdr->src = src;
+      hdr->n = n;
+      hdr->graph_hash = graph_hash;
+      hdr->target_hash = target_hash;
+      if (my_rank == 0)
+         MPI_File_write_at(ckpt.fh, 0, hdr, sizeof(ckpt_hdr_t), MPI_BYTE,
+               MPI_STATUS_IGNORE);
+   }
+
+   ckpt.steps = steps;
+   ckpt.restart = restart;
+   ckpt.n = n;
+   ckpt.loc_n = loc_n;
+   ckpt.my_first = my_first;
+   ckpt.my_rank = my_rank;
+   ckpt.slot = -1;
+   ckpt.dist = malloc(loc_n*sizeof(dist_t));
+   ckpt.pred = malloc(loc_n*sizeof(int));
+   ckpt.known = malloc(loc_n);
+}  /* Open_ckpt */
+
+
+/* A 64-bit mix of x, from splitmix64 */
+static uint64_t Mix64(uint64_t x) {
+   x += 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}  /* Mix64 */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Hash_graph
+ * Purpose:     Hash the weights of the graph for the checkpoint 
+ *              header.  See note 28.
+ * In args:     loc_mat:  the calling process' block column
+ *              n:  the number of vertices
+ *              loc_n:  the number of columns in loc_mat
+ *              my_first:  the first vertex owned by the process
+ *              comm:  Communicator consisting of all the processes
+ * Ret val:     The sum of the hashes of the edges, the same on every
+ *              process and for any number of processes
+ */
+uint64_t Hash_graph(weight_t loc_mat[], int n, int loc_n, int my_first, 
+      MPI_Comm comm) {
+   uint64_t my_hash = 0, hash, bits;
+   weight_t w;
+   int u, v;
+
+   for (u = 0; u < n; u++)
+      for (v = 0; v < loc_n; v++) {
+         w = loc_mat[(size_t) u*loc_n + v];
+         if (w >= NO_EDGE) continue;
+         bits = 0;
+         memcpy(&bits, &w, sizeof(weight_t));
+         my_hash += Mix64(Mix64(((uint64_t) u << 32 | (v + my_first))) 
+               ^ bits);
+      }
+   MPI_Allreduce(&my_hash, &hash, 1, MPI_UINT64_T, MPI_SUM, comm);
+   COUNT_COLL(sizeof(uint64_t));
+   return hash;
+}  /* Hash_graph */
+
+
+/* Hash of the sorted list of targets, or 0 without -t */
+uint64_t Hash_targets(int targets[], int n_targets) {
+   uint64_t hash = 0;
+   int i;
+
+   for (i = 0; i < n_targets; i++)
+      hash = Mix64(hash ^ (uint32_t) targets[i]);
+   return hash;
+}  /* Hash_targets */
+
+
+/* Offset of slot in the checkpoint file */
+static MPI_Offset Slot_offset(int slot) {
+   return sizeof(ckpt_hdr_t) 
+      + (MPI_Offset) slot*ckpt.n*(sizeof(dist_t) + sizeof(int) + 1);
+}  /* Slot_offset */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Save_ckpt
+ * Purpose:     Copy the solver's state and start writing it to the
+ *              older slot of the checkpoint file without waiting.
+ *              The previous write is finished first.  See note 28.
+ * In args:     loc_dist, loc_pred:  local distances and predecessors
+ *              known:  the known bitmap
+ *              step:  the pass the solver will resume at
+ *              remaining:  the number of targets the solver still 
+ *                 has to settle
+ *
+ * Note:        The file has two slots and a save overwrites the older
+ *              one.  Finish_ckpt records a slot in the header only
+ *              after it's synced, so a job killed during a write still
+ *              has the last finished checkpoint.
+ */
+void Save_ckpt(dist_t loc_dist[], int loc_pred[], uint32_t known[], 
+      int64_t step, int64_t remaining) {
+   MPI_Offset base;
+   int v;
+   double t0;
+
+   Finish_ckpt();
+   TIC(t0);
+   memcpy(ckpt.dist, loc_dist, ckpt.loc_n*sizeof(dist_t));
+   memcpy(ckpt.pred, loc_pred, ckpt.loc_n*sizeof(int));
+   for (v = 0; v < ckpt.loc_n; v++)
+      ckpt.known[v] = IS_KNOWN(known, v);
+
+   ckpt.slot = (ckpt.hdr.step[0] <= ckpt.hdr.step[1]) ? 0 : 1;
+   ckpt.step = step;
+   ckpt.remaining = remaining;
+   base = Slot_offset(ckpt.slot);
+   MPI_File_iwrite_at_all(ckpt.fh, 
+         base + (MPI_Offset) ckpt.my_first*sizeof(dist_t), ckpt.dist, 
+         ckpt.loc_n, DIST_MPI, &ckpt.reqs[0]);
+   MPI_File_iwrite_at_all(ckpt.fh, base + (MPI_Offset) ckpt.n*sizeof(dist_t)
+         + (MPI_Offset) ckpt.my_first*sizeof(int), ckpt.pred, ckpt.loc_n, 
+         MPI_INT, &ckpt.reqs[1]);
+   MPI_File_iwrite_at_all(ckpt.fh, 
+         base + (MPI_Offset) ckpt.n*(sizeof(dist_t) + sizeof(int)) 
+         + ckpt.my_first, ckpt.known, ckpt.loc_n, MPI_BYTE, &ckpt.reqs[2]);
+   TOC(t0, T_CKPT);
+}  /* Save_ckpt */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Finish_ckpt
+ * Purpose:     Wait for the checkpoint being written, if there is 
+ *              one, and record it in the header.  See note 28.
+ */
+void Finish_ckpt(void) {
+   double t0;
+
+   if (ckpt.slot < 0) return;
+   TIC(t0);
+   MPI_Waitall(3, ckpt.reqs, MPI_STATUSES_IGNORE);
+
+   /* The slot has to be on disk before the header says it's there, */
+   /* and the header before the other slot is overwritten            */
+   MPI_File_sync(ckpt.fh);
+   ckpt.hdr.step[ckpt.slot] = ckpt.step;
+   ckpt.hdr.remaining[ckpt.slot] = ckpt.remaining;
+   if (ckpt.my_rank == 0)
+      MPI_File_write_at(ckpt.fh, 0, &ckpt.hdr, sizeof(ckpt_hdr_t), 
+            MPI_BYTE, MPI_STATUS_IGNORE);
+   MPI_File_sync(ckpt.fh);
+   ckpt.slot = -1;
+   TOC(t0, T_CKPT);
+}  /* Finish_ckpt */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Restore_ckpt
+ * Purpose:     With -r, read the newest checkpoint into the solver's
+ *              state.  Only the first solve is restored.  See note 28.
+ * Out args:    loc_dist, loc_pred:  local distances and predecessors
+ *              known:  the known bitmap.  It should be cleared on 
+ *                 entry.
+ *              step_p:  the pass to resume at
+ *              remaining_p:  the number of targets left to settle
+ * Ret val:     1 if the state was restored, 0 if there's no 
+ *              checkpoint to restore
+ */
+int Restore_ckpt(dist_t loc_dist[], int loc_pred[], uint32_t known[], 
+      int* step_p, int* remaining_p) {
+   MPI_Offset base;
+   int slot, v;
+   double t0;
+
+   if (ckpt.fh == MPI_FILE_NULL || !ckpt.restart) return 0;
+   ckpt.restart = 0;
+   slot = (ckpt.hdr.step[0] >= ckpt.hdr.step[1]) ? 0 : 1;
+   if (ckpt.hdr.step[slot] == 0) return 0;
+
+   TIC(t0);
+   base = Slot_offset(slot);
+   MPI_File_read_at_all(ckpt.fh, 
+         base + (MPI_Offset) ckpt.my_first*sizeof(dist_t), loc_dist, 
+         ckpt.loc_n, DIST_MPI, MPI_STATUS_IGNORE);
+   MPI_File_read_at_all(ckpt.fh, base + (MPI_Offset) ckpt.n*sizeof(dist_t)
+         + (MPI_Offset) ckpt.my_first*sizeof(int), loc_pred, ckpt.loc_n, 
+         MPI_INT, MPI_STATUS_IGNORE);
+   MPI_File_read_at_all(ckpt.fh, 
+         base + (MPI_Offset) ckpt.n*(sizeof(dist_t) + sizeof(int)) 
+         + ckpt.my_first, ckpt.known, ckpt.loc_n, MPI_BYTE, 
+         MPI_STATUS_IGNORE);
+   for (v = 0; v < ckpt.loc_n; v++)
+      if (ckpt.known[v]) SET_KNOWN(known, v);
+   *step_p = ckpt.hdr.step[slot];
+   *remaining_p = ckpt.hdr.remaining[slot];
+   TOC(t0, T_CKPT);
+   return 1;
+}  /* Restore_ckpt */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Close_ckpt
+ * Purpose:     Finish the last checkpoint, close the file and free 
+ *              the copies of the state
+ */
+void Close_ckpt(void) {
+   Finish_ckpt();
+   MPI_File_close(&ckpt.fh);
+   free(ckpt.dist);
+   free(ckpt.pred);
+   free(ckpt.known);
+}  /* Close_ckpt */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Index_tree
+ * Purpose:     Gather the distances and predecessors from src on 
+ *              process 0 and index the shortest-path tree there.
+ *              See note 29.
+ * In args:     loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors.  Every vertex should be settled.
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              src:  the source vertex
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ * Out arg:     tree:  the index on process 0.  It's empty on the 
+ *                 other processes.  The caller should free it with
+ *                 Free_tree.
+ */
+void Index_tree(dist_t loc_dist[], int loc_pred[], int n, part_t* part, 
+      int src, tree_t* tree, int my_rank, MPI_Comm comm) {
+   /* work.dist and work.pred are NULL except on process 0 */
+   MPI_Gatherv(loc_dist, part->counts[my_rank], DIST_MPI, work.dist, 
+         part->counts, part->first, DIST_MPI, 0, comm);
+   COUNT_COLL(part->counts[my_rank]*sizeof(dist_t));
+   MPI_Gatherv(loc_pred, part->counts[my_rank], MPI_INT, work.pred, 
+         part->counts, part->first, MPI_INT, 0, comm);
+   COUNT_COLL(part->counts[my_rank]*sizeof(int));
+
+   memset(tree, 0, sizeof(tree_t));
+   if (my_rank == 0) Build_tree(work.dist, work.pred, n, src, tree);
+}  /* Index_tree */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Build_tree
+ * Purpose:     Build the children lists of the tree rooted at src
+ *              and number its vertices in DFS preorder.  See note 29.
+ * In args:     dist:  the distances from src of all n vertices
+ *              pred:  their predecessors
+ *              n:  the number of vertices
+ *              src:  the source vertex
+ * Out arg:     tree:  the index
+ *
+ * Note:        The subtree of u is the interval tin[u] .. tout[u] of
+ *              the preorder, so u is an ancestor of v if and only if
+ *              tin[u] <= tin[v] <= tout[u].
+ */
+void Build_tree(dist_t dist[], int pred[], int n, int src, tree_t* tree) {
+   int *child_ptr, *child, *next, *stack;
+   int u, v, top, t = 0;
+
+   tree->n = n;
+   tree->src = src;
+   tree->dist = malloc(n*sizeof(dist_t));
+   tree->pred = malloc(n*sizeof(int));
+   tree->depth = malloc(n*sizeof(int));
+   tree->tin = malloc(n*sizeof(int));
+   tree->tout = malloc(n*sizeof(int));
+   tree->order = malloc(n*sizeof(int));
+   memcpy(tree->dist, dist, n*sizeof(dist_t));
+
+   /* The children of u are child[child_ptr[u]], ..., in increasing */
+   /* order                                                          */
+   child_ptr = calloc(n + 1, sizeof(int));
+   child = malloc(n*sizeof(int));
+   next = malloc(n*sizeof(int));
+   stack = malloc(n*sizeof(int));
+   for (v = 0; v < n; v++) {
+      if (v != src && dist[v] < INFINITY) {
+         tree->pred[v] = pred[v];
+         child_ptr[pred[v] + 1]++;
+      } else {
+         tree->pred[v] = -1;
+      }
+      tree->depth[v] = tree->tin[v] = tree->tout[v] = -1;
+   }
+   for (u = 0; u < n; u++)
+      child_ptr[u+1] += child_ptr[u];
+   memcpy(next, child_ptr, n*sizeof(int));
+   for (v = 0; v < n; v++)
+      if (tree->pred[v] >= 0)
+         child[next[tree->pred[v]]++] = v;
+
+   /* next[u] is u's next child to enter */
+   memcpy(next, child_ptr, n*sizeof(int));
+   tree->tin[src] = 0;
+   tree->order[0] = src;
+   tree->depth[src] = 0;
+   stack[0] = src;
+   top = 1;
+   while (top > 0) {
+      u = stack[top-1];
+      if (next[u] < child_ptr[u+1]) {
+         v = child[next[u]++];
+         tree->tin[v] = ++t;
+         tree->order[t] = v;
+         tree->depth[v] = tree->depth[u] + 1;
+         stack[top++] = v;
+      } else {
+         tree->tout[u] = t;
+         top--;
+      }
+   }
+
+   free(child_ptr);
+   free(child);
+   free(next);
+   free(stack);
+}  /* Build_tree */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_tree
+ * Purpose:     Free the arrays of a tree index
+ * In/out arg:  tree:  the index
+ */
+void Free_tree(tree_t* tree) {
+   free(tree->dist);
+   free(tree->pred);
+   free(tree->depth);
+   free(tree->tin);
+   free(tree->tout);
+   free(tree->order);
+}  /* Free_tree */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Write_tree
+ * Purpose:     Write a tree index to a binary file.  See note 29.
+ * In args:     tree:  the index
+ *              fname:  the name of the file
+ * Ret val:     1, or 0 if the file couldn't be written
+ */
+int Write_tree(tree_t* tree, char fname[]) {
+   FILE* fp;
+   tree_hdr_t hdr;
+   size_t n = tree->n;
+   int ok;
+
+   if ((fp = fopen(fname, "wb")) == NULL) return 0;
+   memset(&hdr, 0, sizeof(hdr));
+   memcpy(hdr.magic, TREE_MAGIC, 4);
+   hdr.version = TREE_VERSION;
+   hdr.dist_type = DIST_CODE;
+   hdr.src = tree->src;
+   hdr.n = tree->n;
+   ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1
+      && fwrite(tree->dist, sizeof(dist_t), n, fp) == n
+      && fwrite(tree->pred, sizeof(int), n, fp) == n
+      && fwrite(tree->depth, sizeof(int), n, fp) == n
+      && fwrite(tree->tin, sizeof(int), n, fp) == n
+      && fwrite(tree->tout, sizeof(int), n, fp) == n
+      && fwrite(tree->order, sizeof(int), n, fp) == n;
+   if (fclose(fp) != 0) ok = 0;
+   return ok;
+}  /* Write_tree */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Export_tree
+ * Purpose:     Index the shortest-path tree from src and write it to
+ *              fname for -x.  See note 29.
+ * In args:     loc_dist, loc_pred:  the process' distances and 
+ *                 predecessors
+ *              n:  the number of vertices
+ *              part:  the vertices owned by each process
+ *              src:  the source vertex
+ *              fname:  the name of the file
+ *              my_rank:  the calling process' rank
+ *              comm:  Communicator consisting of all the processes
+ */
+void Export_tree(dist_t loc_dist[], int loc_pred[], int n, part_t* part, 
+      int src, char fname[], int my_rank, MPI_Comm comm) {
+   tree_t tree;
+   int local_ok = 1;
+
+   Index_tree(loc_dist, loc_pred, n, part, src, &tree, my_rank, comm);
+   if (my_rank == 0) local_ok = Write_tree(&tree, fname);
+   Free_tree(&tree);
+   Check_for_error(local_ok, "Can't write the tree file", comm);
+}  /* Export_tree */
+
+
+/*-------------------------------------------------------------------
+ * Function:    On_path
+ * Purpose:     Check in O(1) whether u is on the shortest path from
+ *              the root to v, i.e., whether u is an ancestor of v or
+ *              v itself.  See note 29.
+ * In args:     tree:  the index
+ *              u, v:  vertices
+ * Ret val:     1 if u is on the path, 0 if it isn't or v can't be 
+ *              reached
+ */
+int On_path(tree_t* tree, int u, int v) {
+   return tree->tin[u] >= 0 && tree->tin[v] >= 0 
+      && tree->tin[u] <= tree->tin[v] && tree->tin[v] <= tree->tout[u];
+}  /* On_path */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Print_tree_path
+ * Purpose:     Print the length of the shortest path from the root to
+ *              v and the path, in O(depth[v]).  See note 29.
+ * In args:     tree:  the index
+ *              v:  the last vertex on the path
+ */
+void Print_tree_path(tree_t* tree, int v) {
+   char *line, *start;
+   int w, len;
+
+   if (tree->tin[v] < 0) {
+      printf("No path %d->%d\n", tree->src, v);
+      return;
+   }
+
+   /* Each vertex takes at most 11 characters and a blank */
+   len = 12*(tree->depth[v] + 1);
+   line = malloc(len + 1);
+   line[len] = '\n';
+   start = &line[len];
+   for (w = v; w != tree->src; w = tree->pred[w])
+      start = Put_vertex(start, w);
+   start = Put_vertex(start, tree->src);
+   printf("Path %d->%d, length %" DIST_FMT ":  ", tree->src, v, 
+         tree->dist[v]);
+   fwrite(start, 1, &line[len] - start + 1, stdout);
+   free(line);
+}  /* Print_tree_path */